@@ -7,122 +7,191 @@ in vec3 vertexNormal;
 uniform mat4 matModel;
 uniform mat4 mvp;
 uniform mat4 lightSpaceMatrix;
+uniform vec3 albedoColor;
 
 out vec4 fragPosLightSpace;
 out vec3 fragNormal;
 out vec3 fragPos;
+out vec3 fragAlbedo;
 
 void main() {
     fragPos = vec3(matModel * vec4(vertexPosition, 1.0));
     fragNormal = normalize(mat3(matModel) * vertexNormal);
+    fragAlbedo = albedoColor;
 
     gl_Position = mvp * vec4(vertexPosition, 1.0);
 })";
 
-static const char* GLSL_BASIC_FRAG = R"(#version 330
+// same as GLSL_BASIC_VERT but takes the model matrix per instance,
+// the part color and material are packed into the (otherwise unused) bottom row of it
+static const char* GLSL_BASIC_INSTANCED_VERT = R"(#version 330
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+in mat4 instanceTransform;
 
-in vec3 fragNormal;
-in vec3 fragPos;
-in vec4 fragPosLightSpace;
+uniform mat4 mvp;
+uniform mat4 lightSpaceMatrix;
+uniform vec2 tileCount;     // texture tiles per stud
 
-uniform sampler2D shadowMap;
-uniform vec3 viewPos;
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 ambientColor;
-uniform vec3 albedoColor;
+out vec4 fragPosLightSpace;
+out vec3 fragNormal;
+out vec3 fragPos;
+out vec3 fragAlbedo;
+out vec2 fragTexCoord;
+out float fragTextured;
 
-out vec4 finalColor;
+void main() {
+    mat4 model = instanceTransform;
+    fragAlbedo = vec3(model[0][3], model[1][3], model[2][3]);
+    fragTextured = model[3][3];
 
-float ShadowFactor() {
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    projCoords = projCoords * 0.5 + 0.5;
+    model[0][3] = 0.0;
+    model[1][3] = 0.0;
+    model[2][3] = 0.0;
+    model[3][3] = 1.0;
 
-    // outside shadow map = no shadow
-    if (projCoords.z > 1.0) return 1.0;
+    // full size of the part (width, height, depth) is the length of each basis column
+    vec3 partSize = vec3(length(model[0].xyz), length(model[1].xyz), length(model[2].xyz));
 
-    float closestDepth = texture(shadowMap, projCoords.xy).r;
-    float currentDepth = projCoords.z;
+    // project onto the face the normal points out of, scaled to studs
+    vec2 uv;
+    vec3 absNormal = abs(vertexNormal);
 
-    float bias = 0.002;
-    return currentDepth - bias > closestDepth ? 0.3 : 1.0;
-}
+    if (absNormal.x > 0.5) {
+        uv = vertexPosition.yz * partSize.yz;
+    }
+    else if (absNormal.y > 0.5) {
+        uv = vertexPosition.xz * partSize.xz;
+    }
+    else {
+        uv = vertexPosition.xy * partSize.xy;
+    }
 
-void main() {
-    vec3 N = normalize(fragNormal);
-    vec3 L = normalize(-lightDir);
+    fragTexCoord = uv * tileCount;
 
-    float diff = max(dot(N, L), 0.0);
+    fragPos = vec3(model * vec4(vertexPosition, 1.0));
+    fragNormal = normalize(mat3(model) * vertexNormal);
+    fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
 
-    float shadow = ShadowFactor();
+    gl_Position = mvp * model * vec4(vertexPosition, 1.0);
+})";
 
-    vec3 lighting =
-        ambientColor +
-        diff * lightColor * shadow;
+// depth only pass for the shadow maps, same instance layout as GLSL_BASIC_INSTANCED_VERT
+static const char* GLSL_DEPTH_INSTANCED_VERT = R"(#version 330
+in vec3 vertexPosition;
+in mat4 instanceTransform;
+
+uniform mat4 mvp;
 
-    vec3 color = albedoColor * lighting;
+void main() {
+    mat4 model = instanceTransform;
+    model[0][3] = 0.0;
+    model[1][3] = 0.0;
+    model[2][3] = 0.0;
+    model[3][3] = 1.0;
 
-    finalColor = vec4(color, 1.0);
+    gl_Position = mvp * model * vec4(vertexPosition, 1.0);
 })";
 
-static const char* GLSL_TEXTURE_VERT = R"(#version 330
-
+// baked static chunks, vertices are already in world space
+// the vertex color carries the albedo in rgb and the textured flag in alpha
+static const char* GLSL_STATIC_VERT = R"(#version 330
 in vec3 vertexPosition;
 in vec3 vertexNormal;
+in vec2 vertexTexCoord;
+in vec4 vertexColor;
 
 uniform mat4 mvp;
-uniform vec3 partSize;      // full size of the part (width, height, depth)
-uniform vec2 tileCount;     // tiles per face
+uniform mat4 lightSpaceMatrix;
 
+out vec4 fragPosLightSpace;
+out vec3 fragNormal;
+out vec3 fragPos;
+out vec3 fragAlbedo;
 out vec2 fragTexCoord;
+out float fragTextured;
 
-void main()
-{
-    vec2 uv;
-    vec2 scaleAxes;
+void main() {
+    fragAlbedo = vertexColor.rgb;
+    fragTextured = vertexColor.a;
+    fragTexCoord = vertexTexCoord;
 
-    vec3 absNormal = abs(vertexNormal);
+    fragPos = vertexPosition;
+    fragNormal = normalize(vertexNormal);
+    fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
 
-    if (absNormal.x > 0.5) {
-        uv = vertexPosition.yz;
-        scaleAxes = vec2(partSize.y, partSize.z);  // use Y & Z
-    }
-    else if (absNormal.y > 0.5) {
-        uv = vertexPosition.xz;
-        scaleAxes = vec2(partSize.x, partSize.z);  // use X & Z
-    }
-    else {
-        uv = vertexPosition.xy;
-        scaleAxes = vec2(partSize.x, partSize.y);  // use X & Y
-    }
-
-    // normalize by face size along those axes
-    uv /= scaleAxes;
+    gl_Position = mvp * vec4(vertexPosition, 1.0);
+})";
 
-    // tile the texture
-    uv *= tileCount;
+// depth only pass for the baked static chunks
+static const char* GLSL_DEPTH_VERT = R"(#version 330
+in vec3 vertexPosition;
 
-    fragTexCoord = uv;
+uniform mat4 mvp;
 
+void main() {
     gl_Position = mvp * vec4(vertexPosition, 1.0);
 })";
 
-static const char* GLSL_TEXTURE_FRAG = R"(#version 330
+static const char* GLSL_BASIC_FRAG = R"(#version 330
 
-in vec2 fragTexCoord;
 in vec3 fragNormal;
+in vec3 fragPos;
+in vec4 fragPosLightSpace;
+in vec3 fragAlbedo;
+in vec2 fragTexCoord;
+in float fragTextured;
 
-uniform sampler2D texture0;
+uniform sampler2D texture0;        // PartTexture.png, used by textured materials
+uniform sampler2D shadowMap;       // parts that can move, redrawn every frame
+uniform sampler2D staticShadowMap; // anchored parts, only redrawn when they or the light change
+uniform vec3 viewPos;
+
+// frame constant lighting, uploaded in one call per frame (see FrameLighting in Rendering.cpp)
+uniform vec3 frameLighting[4];
+#define lightDir frameLighting[0]
+#define lightColor frameLighting[1]
+#define ambientColor frameLighting[2]
+#define shadowParams frameLighting[3] // x = enabled, y = depth bias
 
 out vec4 finalColor;
 
+float ShadowFactor() {
+    if (shadowParams.x < 0.5) return 1.0;
+
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5;
+
+    // outside shadow map = no shadow
+    if (projCoords.z > 1.0) return 1.0;
+    if (any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0)))) return 1.0;
+
+    float closestDepth = min(texture(shadowMap, projCoords.xy).r, texture(staticShadowMap, projCoords.xy).r);
+    float currentDepth = projCoords.z;
+
+    float bias = shadowParams.y;
+    return currentDepth - bias > closestDepth ? 0.3 : 1.0;
+}
+
 void main() {
-    vec4 texColor = texture(texture0, fragTexCoord);
+    vec3 N = normalize(fragNormal);
+    vec3 L = normalize(-lightDir);
+
+    float diff = max(dot(N, L), 0.0);
+
+    float shadow = ShadowFactor();
 
-    // if(texColor.a < 0.1)
-        // discard;
+    vec3 lighting =
+        ambientColor +
+        diff * lightColor * shadow;
 
-    finalColor = texColor;
+    // sampled unconditionally so mipmap derivatives stay defined
+    vec3 texColor = texture(texture0, fragTexCoord).rgb;
+    vec3 albedo = fragAlbedo * mix(vec3(1.0), texColor, fragTextured);
+
+    vec3 color = albedo * lighting;
+
+    finalColor = vec4(color, 1.0);
 })";
 
 static const char* GLSL_DEPTH_FRAG = R"(#version 330
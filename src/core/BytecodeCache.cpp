@@ -0,0 +1,157 @@
+#include "BytecodeCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <raylib.h>
+
+#include "luacode.h"
+#include "Luau/Bytecode.h"
+
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+// files start with this header, anything that doesn't match (old version, truncated write,
+// hash collision on the file name) is ignored and recompiled
+struct BytecodeFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint64_t size;
+};
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static uint64_t HashString(uint64_t hash, const char *str) {
+	// the terminator goes in too so ("ab", "c") and ("a", "bc") differ, nullptr hashes as nothing
+	if (!str) return hash;
+	return HashBytes(hash, str, std::strlen(str) + 1);
+}
+
+uint64_t HashBytecodeKey(const std::string &source, const lua_CompileOptions &opts) {
+	uint64_t hash = FNV_OFFSET_BASIS;
+
+	// a Luau upgrade that changes the bytecode format changes every key with it
+	uint32_t bytecodeVersion = LBC_VERSION_TARGET;
+
+	hash = HashBytes(hash, &BYTECODE_CACHE_VERSION, sizeof(BYTECODE_CACHE_VERSION));
+	hash = HashBytes(hash, &bytecodeVersion, sizeof(bytecodeVersion));
+
+	hash = HashBytes(hash, &opts.optimizationLevel, sizeof(opts.optimizationLevel));
+	hash = HashBytes(hash, &opts.debugLevel, sizeof(opts.debugLevel));
+	hash = HashBytes(hash, &opts.typeInfoLevel, sizeof(opts.typeInfoLevel));
+	hash = HashBytes(hash, &opts.coverageLevel, sizeof(opts.coverageLevel));
+	hash = HashString(hash, opts.vectorLib);
+	hash = HashString(hash, opts.vectorCtor);
+	hash = HashString(hash, opts.vectorType);
+
+	return HashBytes(hash, source.data(), source.size());
+}
+
+static std::string GetCachePath(const BytecodeCache &cache, uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.luauc", (unsigned long long)key);
+
+	return cache.directory + "/" + name;
+}
+
+static bool ReadCacheFile(const BytecodeCache &cache, uint64_t key, std::string &bytecode) {
+	std::string path = GetCachePath(cache, key);
+	if (!FileExists(path.c_str())) return false;
+
+	int dataSize = 0;
+	unsigned char *data = LoadFileData(path.c_str(), &dataSize);
+	if (!data) return false;
+
+	BytecodeFileHeader header;
+	bool valid = dataSize >= (int)sizeof(header);
+
+	if (valid) {
+		std::memcpy(&header, data, sizeof(header));
+
+		valid = std::memcmp(header.magic, "BLKC", 4) == 0 &&
+				header.version == BYTECODE_CACHE_VERSION &&
+				header.key == key &&
+				header.size > 0 &&
+				header.size == dataSize - sizeof(header);
+	}
+
+	if (valid)
+		bytecode.assign((const char *)data + sizeof(header), header.size);
+
+	UnloadFileData(data);
+	return valid;
+}
+
+static void WriteCacheFile(const BytecodeCache &cache, uint64_t key, const std::string &bytecode) {
+	if (!DirectoryExists(cache.directory.c_str()) && MakeDirectory(cache.directory.c_str()) != 0) {
+		printf("RUNTIME: Failed to create bytecode cache directory '%s'\n", cache.directory.c_str());
+		return;
+	}
+
+	BytecodeFileHeader header;
+	std::memcpy(header.magic, "BLKC", 4);
+	header.version = BYTECODE_CACHE_VERSION;
+	header.key = key;
+	header.size = bytecode.size();
+
+	std::string data((const char *)&header, sizeof(header));
+	data += bytecode;
+
+	std::string path = GetCachePath(cache, key);
+	SaveFileData(path.c_str(), data.data(), (int)data.size());
+}
+
+bool FindBytecode(BytecodeCache &cache, uint64_t key, std::string &bytecode) {
+	auto it = cache.entries.find(key);
+	if (it != cache.entries.end()) {
+		bytecode = it->second;
+		return true;
+	}
+
+	if (cache.useDisk && ReadCacheFile(cache, key, bytecode)) {
+		cache.entries[key] = bytecode;
+		return true;
+	}
+
+	return false;
+}
+
+void StoreBytecode(BytecodeCache &cache, uint64_t key, const std::string &bytecode) {
+	// compile errors are reported by luau_load every time, there's nothing worth keeping
+	if (bytecode.empty() || bytecode[0] == 0)
+		return;
+
+	cache.entries[key] = bytecode;
+
+	if (cache.useDisk)
+		WriteCacheFile(cache, key, bytecode);
+}
+
+void EvictBytecode(BytecodeCache &cache, uint64_t key) {
+	cache.entries.erase(key);
+
+	if (cache.useDisk)
+		std::remove(GetCachePath(cache, key).c_str());
+}
+
+std::string CompileBytecode(const std::string &source, const lua_CompileOptions &opts) {
+	// luau_compile doesn't write to the options, the cast is only for its signature
+	size_t bytecodeSize = 0;
+	char *compiled = luau_compile(source.data(), source.size(),
+								  const_cast<lua_CompileOptions *>(&opts), &bytecodeSize);
+
+	std::string bytecode(compiled ? compiled : "", compiled ? bytecodeSize : 0);
+	free(compiled);
+
+	return bytecode;
+}
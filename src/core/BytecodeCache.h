@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "luacode.h"
+
+// bump when the cache file layout changes, Luau's own bytecode version is part of the key already
+static const uint32_t BYTECODE_CACHE_VERSION = 1;
+
+// compiled bytecode keyed by a hash of the source and the compile options,
+// kept in memory for the session and written to disk so the next run can skip compiling
+struct BytecodeCache {
+	std::string directory = ".blockadia/cache";
+	bool useDisk = true; // off with --no-bytecode-cache, entries then only live for the session
+
+	std::unordered_map<uint64_t, std::string> entries;
+};
+
+extern BytecodeCache gBytecodeCache;
+
+uint64_t HashBytecodeKey(const std::string& source, const lua_CompileOptions& opts);
+
+// memory first, then disk
+bool FindBytecode(BytecodeCache& cache, uint64_t key, std::string& bytecode);
+void StoreBytecode(BytecodeCache& cache, uint64_t key, const std::string& bytecode);
+
+// for entries luau_load rejected, removes the file too
+void EvictBytecode(BytecodeCache& cache, uint64_t key);
+
+// doesn't touch the cache, safe to call from worker threads
+// a failed compile returns Luau's error blob (a 0 byte followed by the message) for luau_load to report
+std::string CompileBytecode(const std::string& source, const lua_CompileOptions& opts);
@@ -59,6 +59,15 @@ struct Game : Instance {
 
 		return Instance::LuaGet(L, key);
 	}
+
+	lua_CFunction LuaMethod(int atom) override {
+		switch (atom) {
+			case ATOM_GetService: return l_GetService;
+			case ATOM_FindService: return l_FindService;
+		}
+
+		return Instance::LuaMethod(atom);
+	}
 };
 
 #endif
\ No newline at end of file
@@ -1,64 +1,107 @@
 #include "LuaScheduler.h"
 
+#include <atomic>
+#include <cctype>
+#include <chrono>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <thread>
 #include <raylib.h>
 
 #include "lua.h"
 #include "luacode.h"
+#include "luacodegen.h"
 #include "lualib.h"
 
 #include "objects/BaseScript.h"
+#include "core/BytecodeCache.h"
+#include "core/RuntimeClock.h"
 
 extern LuaScheduler gLuaScheduler;
 
+// nullptr for threads the scheduler doesn't own, like coroutines made by scripts
 LuaThread *GetCurrentLuaThread(lua_State *L) {
-	auto it = gLuaScheduler.threadMap.find(L);
-	if (it == gLuaScheduler.threadMap.end()) {
-		return nullptr;
-	}
-
-	return it->second;
+	return static_cast<LuaThread *>(lua_getthreaddata(L));
 }
 
 LuaScheduler *GetScheduler(lua_State *L) { 
 	return &gLuaScheduler; 
 }
 
-// UNUSED
+// the execution budget is real time even when headless runs on a fixed clock
+static double GetWallTime() {
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
 
-LuaThread *CreateThread(LuaScheduler &sched, int funcIndex) {
-	lua_State *L = sched.L;
+// looks for a --!native hot comment in the line comments before the first line of code,
+// the same place Luau reads it from
+static bool HasNativeDirective(const std::string &source) {
+	size_t pos = 0;
+
+	while (pos < source.size()) {
+		pos = source.find_first_not_of(" \t\r\n", pos);
+		if (pos == std::string::npos) break;
 
-	if (!lua_isfunction(L, funcIndex)) {
-		const char *typeName = lua_typename(L, lua_type(L, funcIndex));
-		printf("RUNTIME: Failed to create thread, see info below\n");
-		printf(" Message: Expected 'function', got '%s'\n", typeName);
-		return nullptr;
+		// block comments aren't walked, a hot comment has to come before them
+		if (source.compare(pos, 2, "--") != 0 || source.compare(pos, 3, "--[") == 0)
+			break;
+
+		// --!nativeX is a different (unknown) hot comment, Luau wants whitespace or the end after the name
+		if (source.compare(pos, 9, "--!native") == 0 &&
+			(pos + 9 == source.size() || std::isspace((unsigned char)source[pos + 9])))
+			return true;
+
+		pos = source.find('\n', pos);
 	}
 
-	lua_State *thread = lua_newthread(L);
-	luaL_sandboxthread(thread);
+	return false;
+}
 
-	int ref = lua_ref(L, -1);
-	lua_pop(L, 1);
+void EnableNativeCodegen(LuaScheduler &sched) {
+	if (!luau_codegen_supported()) return;
 
-	lua_pushvalue(L, funcIndex);
-	lua_xmove(L, thread, 1);
+	luau_codegen_create(sched.L);
+	sched.nativeCodegen = true;
+}
 
-	auto *t = new LuaThread{};
-	t->thread = thread;
-	t->threadRef = ref;
-	t->scheduler = &sched;
+static lua_CompileOptions GetCompileOptions(const BaseScript *script, bool &native) {
+	// lets the compiler treat Vector3.new as the native vector constructor and
+	// Vector3 annotations as the vector type
+	lua_CompileOptions opts{};
+	opts.vectorLib = "Vector3";
+	opts.vectorCtor = "new";
+	opts.vectorType = "Vector3";
 
-	sched.threads.push_back(t);
-	sched.threadMap[thread] = t;
+	// --!native scripts get the full optimizer, inlining and unrolling help the native code most
+	native = HasNativeDirective(script->Source);
+	if (native)
+		opts.optimizationLevel = 2;
 
-	return t;
+	return opts;
 }
 
-void StartScript(LuaScheduler &sched, BaseScript *script) {
+struct ScriptBuild {
+	BaseScript *script;
+	lua_CompileOptions opts;
+	bool native;
+	uint64_t key;
+	std::string bytecode;
+	bool cached; // came from the bytecode cache instead of a compile this run
+};
+
+// loads compiled bytecode on a new thread and schedules it, runs on the main thread only
+static void LoadScript(LuaScheduler &sched, ScriptBuild &build) {
+	BaseScript *script = build.script;
+
+	if (build.bytecode.empty()) {
+		printf("RUNTIME: Failed to compile bytecode for script %s\n",
+			   script->Name.data());
+		return;
+	}
+
 	lua_State *L = sched.L;
 
 	lua_State *thread = lua_newthread(L);
@@ -67,38 +110,260 @@ void StartScript(LuaScheduler &sched, BaseScript *script) {
 
 	luaL_sandboxthread(thread);
 
-	lua_CompileOptions opts{};
+	const std::string chunkName = "@" + script->Name;
+	int status = luau_load(thread, chunkName.c_str(), build.bytecode.data(), build.bytecode.size(), 0);
 
-	size_t bytecodeSize = 0;
-	char *bytecode = luau_compile(script->Source.data(), script->Source.size(),
-								  &opts, &bytecodeSize);
-	if (!bytecode || bytecodeSize == 0) {
-		printf("RUNTIME: Failed to compile bytecode for script %s\n",
-			   script->Name.data());
-		if (bytecode)
-			free(bytecode);
-		return;
+	// a cached entry Luau won't take anymore (damaged file, or a bytecode version it dropped)
+	// is thrown out and the script compiled again from source
+	if (status != 0 && build.cached) {
+		lua_pop(thread, 1);
+		EvictBytecode(gBytecodeCache, build.key);
+
+		build.bytecode = CompileBytecode(script->Source, build.opts);
+		build.cached = false;
+		StoreBytecode(gBytecodeCache, build.key, build.bytecode);
+
+		status = luau_load(thread, chunkName.c_str(), build.bytecode.data(), build.bytecode.size(), 0);
 	}
 
-	const std::string chunkName = "@" + script->Name;
-	if (luau_load(thread, chunkName.c_str(), bytecode, bytecodeSize, 0) != 0) {
+	if (status != 0) {
 		printf("RUNTIME: Failed to load bytecode for script %s\n",
 			   script->Name.data());
 		printf("  Message: %s\n", lua_tostring(thread, -1));
 		lua_pop(thread, 1);
-		free(bytecode);
+		lua_unref(L, ref);
 		return;
 	}
 
-	free(bytecode);
+	// falls back to the interpreter when codegen isn't available
+	if (build.native && sched.nativeCodegen) {
+		luau_codegen_compile(thread, -1);
+	} else if (build.native) {
+		printf("RUNTIME: Native code isn't supported on this platform, script %s is interpreted\n",
+			   script->Name.data());
+	}
 
 	auto *t = new LuaThread{};
 	t->thread = thread;
 	t->threadRef = ref;
 	t->scheduler = &sched;
+	t->source = script->Name;
 
-	sched.threads.push_back(t);
-	sched.threadMap[thread] = t;
+	lua_setthreaddata(thread, t);
+	sched.threadCount++;
+	sched.Schedule(t);
+}
+
+// enabled scripts in tree order, LocalScripts are left alone since there is no client
+static void CollectScripts(Instance *inst, std::vector<BaseScript *> &scripts) {
+	BaseScript *script = dynamic_cast<BaseScript *>(inst);
+	if (script && script->Enabled && std::strcmp(script->ClassName(), "LocalScript") != 0)
+		scripts.push_back(script);
+
+	for (Instance *child : inst->Children) {
+		CollectScripts(child, scripts);
+	}
+}
+
+void StartScripts(LuaScheduler &sched, const std::vector<Instance *> &containers) {
+	std::vector<BaseScript *> scripts;
+	for (Instance *container : containers) {
+		CollectScripts(container, scripts);
+	}
+
+	std::vector<ScriptBuild> builds(scripts.size());
+	std::vector<ScriptBuild *> misses;
+
+	for (size_t i = 0; i < scripts.size(); i++) {
+		ScriptBuild &build = builds[i];
+		build.script = scripts[i];
+		build.native = false;
+		build.opts = GetCompileOptions(build.script, build.native);
+		build.key = HashBytecodeKey(build.script->Source, build.opts);
+
+		build.cached = FindBytecode(gBytecodeCache, build.key, build.bytecode);
+		if (!build.cached)
+			misses.push_back(&build);
+	}
+
+	// luau_compile is thread safe, each worker takes the next uncompiled script until none are left
+	// so the slowest compile bounds the wait instead of the sum of them
+	size_t workerCount = std::thread::hardware_concurrency();
+	if (workerCount == 0) workerCount = 1;
+	if (workerCount > misses.size()) workerCount = misses.size();
+
+	std::atomic<size_t> next{0};
+	std::vector<std::thread> workers;
+
+	for (size_t i = 0; i < workerCount; i++) {
+		workers.emplace_back([&]() {
+			for (size_t job = next++; job < misses.size(); job = next++) {
+				ScriptBuild *build = misses[job];
+				build->bytecode = CompileBytecode(build->script->Source, build->opts);
+			}
+		});
+	}
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	// the cache and the VM are only touched from here on, in tree order
+	for (ScriptBuild *build : misses) {
+		StoreBytecode(gBytecodeCache, build->key, build->bytecode);
+	}
+
+	for (ScriptBuild &build : builds) {
+		LoadScript(sched, build);
+	}
+}
+
+void LuaScheduler::Schedule(LuaThread *t) {
+	ready.push_back(t);
+}
+
+void LuaScheduler::Sleep(LuaThread *t, double wakeTime) {
+	sleeping.push({wakeTime, sleepSequence++, t});
+}
+
+static void DestroyThread(LuaScheduler &sched, LuaThread *t) {
+	lua_setthreaddata(t->thread, nullptr);
+	lua_unref(sched.L, t->threadRef);
+
+	sched.threadCount--;
+	delete t;
+}
+
+// task library threads come from a free list, a finished one is reset and kept
+// along with its registry ref instead of making the GC collect it
+static LuaThread *AcquireThread(LuaScheduler &sched) {
+	LuaThread *t;
+
+	if (!sched.freeThreads.empty()) {
+		t = sched.freeThreads.back();
+		sched.freeThreads.pop_back();
+	} else {
+		lua_State *thread = lua_newthread(sched.L);
+		int ref = lua_ref(sched.L, -1);
+		lua_pop(sched.L, 1);
+
+		t = new LuaThread{};
+		t->thread = thread;
+		t->threadRef = ref;
+		t->scheduler = &sched;
+		t->pooled = true;
+
+		lua_setthreaddata(thread, t);
+	}
+
+	sched.threadCount++;
+	return t;
+}
+
+static void ReleaseThread(LuaScheduler &sched, LuaThread *t) {
+	if (!t->pooled || sched.freeThreads.size() >= MAX_POOLED_THREADS) {
+		DestroyThread(sched, t);
+		return;
+	}
+
+	lua_resetthread(t->thread);
+
+	t->wakeTime = 0.0;
+	t->yieldTime = 0.0;
+	t->expectsReturn = false;
+	t->waiting = false;
+	t->pendingArgs = 0;
+	t->runTime = 0.0;
+	t->terminated = false;
+
+	sched.threadCount--;
+	sched.freeThreads.push_back(t);
+}
+
+// time spent running past the deadline, reported once a second per script
+static void RecordOverrun(LuaScheduler &sched, const std::string &source, double start, double end,
+						  double deadline) {
+	double overrun = end - (start > deadline ? start : deadline);
+	if (overrun > 0.0)
+		sched.overruns[source] += overrun;
+}
+
+// returns the lua_resume status, the thread has already been released unless it's LUA_YIELD or LUA_BREAK
+static int ResumeThread(LuaScheduler &sched, LuaThread *t, double now, lua_State *from = nullptr) {
+	int nargs = t->pendingArgs;
+	t->pendingArgs = 0;
+
+	if (t->expectsReturn) {
+		t->expectsReturn = false;
+
+		double elapsed = now - t->yieldTime;
+		lua_pushnumber(t->thread, elapsed);
+		nargs = 1;
+	}
+
+	// task.spawn resumes inside another thread, put it back once this one stops
+	LuaThread *previous = sched.current;
+	sched.current = t;
+
+	double start = GetWallTime();
+	t->resumeTime = start;
+	int status = lua_resume(t->thread, from, nargs);
+	double end = GetWallTime();
+
+	sched.current = previous;
+	t->runTime += end - start;
+
+	RecordOverrun(sched, t->source, start, end, sched.frameDeadline);
+
+	if (status == LUA_BREAK) {
+		// went over the frame budget, carry on where it stopped next step
+		sched.Schedule(t);
+	} else if (status == LUA_YIELD) {
+		t->runTime = 0.0;
+
+		// task.wait parks the thread, any other yield resumes it next step
+		if (t->waiting)
+			sched.Sleep(t, t->wakeTime);
+		else
+			sched.Schedule(t);
+	} else if (status == LUA_OK) {
+		ReleaseThread(sched, t);
+	} else {
+		const char *err = lua_tostring(t->thread, -1);
+		printf("RUNTIME: Lua thread has encountered an error, see info "
+			   "below\n");
+		printf("  Status : %i\n", status);
+		printf("  Message: '%s'\n", err);
+
+		lua_pop(t->thread, 1);
+		ReleaseThread(sched, t);
+	}
+
+	return status;
+}
+
+int PCallWithBudget(LuaScheduler &sched, lua_State *L, int nargs, const std::string &source) {
+	// stands in for a scheduled thread so the interrupt callback can see how long it has run,
+	// the main state isn't yieldable so it's never broken out of
+	LuaThread call{};
+	call.thread = L;
+	call.source = source;
+	call.scheduler = &sched;
+
+	LuaThread *previous = sched.current;
+	sched.current = &call;
+
+	double start = GetWallTime();
+	call.resumeTime = start;
+	int status = lua_pcall(L, nargs, 0, 0);
+	double end = GetWallTime();
+
+	sched.current = previous;
+
+	// handlers run outside of Step, each one gets a frame budget of its own
+	RecordOverrun(sched, source, start, end, start + sched.frameBudget);
+
+	return status;
 }
 
 static int l_task_wait(lua_State *L) {
@@ -115,7 +380,7 @@ static int l_task_wait(lua_State *L) {
 		return 0;
 	}
 
-	self->yieldTime = GetTime();
+	self->yieldTime = GetRuntimeTime();
 	self->wakeTime = self->yieldTime + duration;
 	self->expectsReturn = true;
 	self->waiting = true;
@@ -123,31 +388,131 @@ static int l_task_wait(lua_State *L) {
 	return lua_yield(L, 0);
 }
 
-// TODO: reimplement task.spawn
-/*
-static int l_task_spawn(lua_State* L) {
+// moves the function at the bottom of the stack and everything above it onto a pooled thread,
+// then leaves that thread on the stack as the return value
+// a handle the script ends up keeping must never be reset and reused for another task, so
+// callers that return it while the task is still alive take the thread out of the pool
+static LuaThread *PrepareTask(lua_State *L, LuaScheduler &sched) {
 	luaL_checktype(L, 1, LUA_TFUNCTION);
 
-	LuaScheduler* sched = GetScheduler(L);
-	if (!sched) {
-		luaL_error(L, "task.spawn must be called from a coroutine");
-		return 0;
+	LuaThread *t = AcquireThread(sched);
+
+	LuaThread *parent = GetCurrentLuaThread(L);
+	t->source = parent ? parent->source : "task";
+
+	int top = lua_gettop(L);
+	lua_xmove(L, t->thread, top);
+	t->pendingArgs = top - 1;
+
+	lua_pushthread(t->thread);
+	lua_xmove(t->thread, L, 1);
+
+	return t;
+}
+
+// resumes right away, inside the caller
+static int l_task_spawn(lua_State *L) {
+	LuaScheduler *sched = GetScheduler(L);
+	LuaThread *t = PrepareTask(L, *sched);
+
+	int status = ResumeThread(*sched, t, GetRuntimeTime(), L);
+
+	if (status == LUA_YIELD || status == LUA_BREAK) {
+		t->pooled = false;
+	} else {
+		// the thread already went back to the pool, hand out a dead one in its place so
+		// only tasks that finish right away (the common case) get recycled
+		lua_pop(L, 1);
+		lua_getref(L, sched->deadThreadRef);
 	}
 
-	lua_pushvalue(L, 1);
+	return 1;
+}
 
-	int funcIndex = lua_gettop(L);
-	StartScript(*sched, funcIndex);
+// resumes on the next scheduler step
+static int l_task_defer(lua_State *L) {
+	LuaScheduler *sched = GetScheduler(L);
+	LuaThread *t = PrepareTask(L, *sched);
+	t->pooled = false;
 
-	lua_pop(L, 1);
-	return 0;
+	sched->Schedule(t);
+	return 1;
+}
+
+// resumes once the given amount of seconds has passed
+static int l_task_delay(lua_State *L) {
+	double duration = luaL_checknumber(L, 1);
+
+	// checked before the duration is removed so the error names the right argument
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+	lua_remove(L, 1);
+
+	LuaScheduler *sched = GetScheduler(L);
+	LuaThread *t = PrepareTask(L, *sched);
+	t->pooled = false;
+
+	t->wakeTime = GetRuntimeTime() + (duration < 0 ? 0 : duration);
+	t->waiting = true;
+	sched->Sleep(t, t->wakeTime);
+
+	return 1;
+}
+
+// called by the VM at loop back edges and calls, gc is -1 unless a GC step triggered it
+static void SchedulerInterrupt(lua_State *L, int gc) {
+	if (gc >= 0) return;
+
+	LuaScheduler &sched = gLuaScheduler;
+	LuaThread *t = sched.current;
+	if (!t) return;
+
+	// keeps erroring so a pcall can't swallow the termination
+	if (t->terminated)
+		luaL_error(L, "script '%s' was terminated for running too long", t->source.c_str());
+
+	if (++sched.interruptTicks < INTERRUPT_CHECK_INTERVAL) return;
+	sched.interruptTicks = 0;
+
+	double now = GetWallTime();
+
+	if (t->runTime + (now - t->resumeTime) > sched.terminateAfter) {
+		t->terminated = true;
+		luaL_error(L, "script '%s' was terminated for running too long", t->source.c_str());
+	}
+
+	// only the scheduler's own thread can be broken out of, a break inside a coroutine
+	// made by the script would hand control back to the script instead
+	if (now > sched.frameDeadline && L == t->thread && lua_isyieldable(L))
+		lua_break(L);
+}
+
+static void ReportOverruns(LuaScheduler &sched) {
+	double now = GetWallTime();
+	if (now - sched.lastOverrunReport < 1.0) return;
+
+	sched.lastOverrunReport = now;
+
+	for (auto &[source, seconds] : sched.overruns) {
+		printf("RUNTIME: Script '%s' ran %.2fms over the frame budget\n", source.c_str(),
+			   seconds * 1000.0);
+	}
+
+	sched.overruns.clear();
 }
-*/
 
 void RegisterTaskAPI(lua_State *L) {
+	lua_callbacks(L)->interrupt = SchedulerInterrupt;
+
+	// never resumed, coroutine.status reports it as dead
+	lua_newthread(L);
+	gLuaScheduler.deadThreadRef = lua_ref(L, -1);
+	lua_pop(L, 1);
+
 	lua_newtable(L);
 		lua_pushcfunction(L, l_task_wait, "task.wait"); lua_setfield(L, -2, "wait");
-		//lua_pushcfunction(L, l_task_spawn, "task.spawn"); lua_setfield(L, -2, "spawn");
+		lua_pushcfunction(L, l_task_spawn, "task.spawn"); lua_setfield(L, -2, "spawn");
+		lua_pushcfunction(L, l_task_defer, "task.defer"); lua_setfield(L, -2, "defer");
+		lua_pushcfunction(L, l_task_delay, "task.delay"); lua_setfield(L, -2, "delay");
 	lua_setglobal(L, "task");
 
 	// backwards compatibility
@@ -156,55 +521,36 @@ void RegisterTaskAPI(lua_State *L) {
 }
 
 void LuaScheduler::Step() {
-	double now = GetTime();
+	double now = GetRuntimeTime();
 
-	lua_gc(L, LUA_GCSTEP, 200);
-
-	for (auto it = threads.begin(); it != threads.end();) {
-		LuaThread *t = *it;
+	for (int ref : releasedRefs) {
+		lua_unref(L, ref);
+	}
 
-		if (t->waiting) {
-			if (now < t->wakeTime) {
-				it++;
-				continue;
-			}
+	releasedRefs.clear();
 
-			t->waiting = false;
-		}
+	lua_gc(L, LUA_GCSTEP, 200);
 
-		int nargs = 0;
-		if (t->expectsReturn) {
-			t->expectsReturn = false;
+	// only the threads that are due get touched, in wake order
+	while (!sleeping.empty() && sleeping.top().wakeTime <= now) {
+		LuaThread *t = sleeping.top().thread;
+		sleeping.pop();
 
-			double elapsed = now - t->yieldTime;
-			lua_pushnumber(t->thread, elapsed);
-			nargs = 1;
-		}
+		t->waiting = false;
+		ready.push_back(t);
+	}
 
-		int status =
-			lua_resume(t->thread, nullptr, nargs); // SEGFAULT OCCURS HERE
+	frameDeadline = GetWallTime() + frameBudget;
+	interruptTicks = 0;
 
-		if (status == LUA_YIELD) {
-			++it;
-		} else if (status == LUA_OK) {
-			lua_unref(L, t->threadRef);
+	// anything scheduled while resuming waits for the next step
+	resuming.swap(ready);
 
-			threadMap.erase(t->thread);
-			delete t;
-			it = threads.erase(it);
-		} else {
-			const char *err = lua_tostring(t->thread, -1);
-			printf("RUNTIME: Lua thread has encountered an error, see info "
-				   "below\n");
-			printf("  Status : %i\n", status);
-			printf("  Message: '%s'\n", err);
+	for (LuaThread *t : resuming) {
+		ResumeThread(*this, t, now);
+	}
 
-			lua_unref(L, t->threadRef);
-			lua_pop(t->thread, 1);
+	resuming.clear();
 
-			threadMap.erase(t->thread);
-			delete t;
-			it = threads.erase(it);
-		}
-	}
+	ReportOverruns(*this);
 }
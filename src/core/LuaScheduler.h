@@ -1,12 +1,21 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "objects/BaseScript.h"
 
 #include "lua.h"
 
+static const size_t MAX_POOLED_THREADS = 1024;
+
+// how often the interrupt callback reads the clock, it runs on every loop back edge and call
+static const int INTERRUPT_CHECK_INTERVAL = 256;
+
 struct LuaScheduler; // forward def
 struct LuaThread {
 	lua_State* thread;
@@ -17,28 +26,104 @@ struct LuaThread {
 	bool expectsReturn = false;
 	bool waiting = false;
 
+	// values already on the thread's stack for its first resume (task library arguments)
+	int pendingArgs = 0;
+
+	// made by the task library, goes back to the free list once it finishes
+	// cleared once a script holds the thread, a reset thread would be someone else's task
+	bool pooled = false;
+
+	// script the thread belongs to, task library threads take it from the thread that made them
+	std::string source;
+
+	// seconds spent running since the thread last yielded on its own, breaks don't reset it
+	double runTime = 0.0;
+	double resumeTime = 0.0;
+	bool terminated = false;
+
 	LuaScheduler* scheduler;
 };
 
+// entry in the sleep heap, the sequence keeps threads that wake at the same time in order
+struct SleepingThread {
+	double wakeTime;
+	uint64_t sequence;
+	LuaThread* thread;
+};
+
+struct WakesLater {
+	bool operator()(const SleepingThread& a, const SleepingThread& b) const {
+		if (a.wakeTime != b.wakeTime) return a.wakeTime > b.wakeTime;
+		return a.sequence > b.sequence;
+	}
+};
+
 struct LuaScheduler {
 	lua_State* L;
-	std::vector<LuaThread*> threads;
 
-	std::unordered_map<lua_State*, LuaThread*> threadMap;
+	// threads to resume on the next Step, and threads parked by task.wait ordered by wake time
+	// a LuaThread is reachable from its lua_State through lua_getthreaddata
+	std::vector<LuaThread*> ready;
+	std::vector<LuaThread*> resuming;
+	std::priority_queue<SleepingThread, std::vector<SleepingThread>, WakesLater> sleeping;
+	uint64_t sleepSequence = 0;
+
+	// finished task library threads, reset and ready to be reused
+	std::vector<LuaThread*> freeThreads;
+
+	// returned by task.spawn in place of a pooled thread that already finished
+	int deadThreadRef = LUA_NOREF;
+
+	// registry refs dropped while the API couldn't be called (userdata destructors), unref'd by Step
+	std::vector<int> releasedRefs;
+
+	size_t threadCount = 0;
+
+	// seconds of Lua execution allowed per Step, threads still running past it are
+	// broken out of and resumed next Step, a thread that keeps running for
+	// terminateAfter seconds without yielding is killed
+	double frameBudget = 0.008;
+	double terminateAfter = 5.0;
+
+	// set while a thread is being resumed, read by the interrupt callback
+	LuaThread* current = nullptr;
+	double frameDeadline = 0.0;
+	int interruptTicks = 0;
+
+	// seconds each script ran past the frame budget since the last report
+	std::unordered_map<std::string, double> overruns;
+	double lastOverrunReport = 0.0;
+
+	// set once Luau's native code generator is attached to L, --!native scripts are
+	// compiled to machine code when it is
+	bool nativeCodegen = false;
 
 	void Step();
+
+	void Schedule(LuaThread* t);
+	void Sleep(LuaThread* t, double wakeTime);
+
+	bool HasThreads() const {
+		return threadCount > 0;
+	}
 };
 
 extern LuaScheduler gLuaScheduler;
 
 // lua handling
 
-LuaThread* CreateThread(lua_State* L);
-void StartScript(LuaScheduler& sched, BaseScript* script);
+// lua_pcall with the same limits as scheduled threads, for callbacks run outside of them
+// (signal handlers), they can't be paused so they only get terminated
+int PCallWithBudget(LuaScheduler& sched, lua_State* L, int nargs, const std::string& source);
+// compiles every enabled Script under the containers in parallel, then loads them in tree order
+void StartScripts(LuaScheduler& sched, const std::vector<Instance*>& containers);
+void EnableNativeCodegen(LuaScheduler& sched);
 
 // lua functions
 
 static int l_task_wait(lua_State* L);
 static int l_task_spawn(lua_State* L);
+static int l_task_defer(lua_State* L);
+static int l_task_delay(lua_State* L);
 
 void RegisterTaskAPI(lua_State* L);
\ No newline at end of file
@@ -18,23 +18,36 @@
 #include "services/StarterGui.h"
 #include "services/Workspace.h"
 
+#include "utils/AABBTree.h"
 #include "utils/ExtraMath.h"
 #include "utils/VecMath.h"
 
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
 // config options
 
 static const float vMinRenderDistance = 0.05f;
 static const float vMaxRenderDistance = 50000.f;
 
-static const bool vDoTexturePass = false;
+// lod settings, projected radius in pixels under which a part drops to the next lod
+static const int vLodCount = 3;
+static const float vLodPixelRadius[vLodCount - 1] = {48.f, 12.f};
+static const float vLodHysteresis = 0.2f;
+static const int vLodSegments[vLodCount] = {16, 10, 6};
+static const int vShadowLod = 1; // shadow maps are too coarse to need the finest meshes
 
-// texture settings
+// texture settings, tiles per stud for textured materials
 static const Vector2 textureScale = {1.0f, 1.0f};
 
 // shadow settings
 
 static const float vShadowRange = 500.f;
-static const int vShadowResolution = 512;
+static const int vShadowResolution = 2048;
+static const float vShadowCasterDistance = 500.f; // how far towards the sun casters are still picked up
+static const float vShadowBias = 0.25f; // in studs
 static const float vOutlineStrength = 0.f;
 
 // end config options
@@ -45,14 +58,69 @@ extern StarterGui *gStarterGui;
 
 bool rendererReady = false;
 static RenderTexture shadowMap;
+static RenderTexture staticShadowMap;
 static Material material;
 static Mesh meshCube;
-static Mesh meshBall;
-static Mesh meshCylinder;
+static Mesh meshBall[vLodCount];
+static Mesh meshCylinder[vLodCount];
 static Shader gBasicShader;
-static Shader gTextureShader;
+static Shader gStaticShader;
+static Shader gDepthShader;
+static Shader gStaticDepthShader;
+static Material staticMaterial;
+static Material depthMaterial;
+static Material staticDepthMaterial;
 static Texture partTexture;
 
+// uniform locations, resolved once in ReadyRenderer
+// the instanced and the static shader share the lit fragment shader, so they share the layout
+struct LitShaderLocs {
+	int frameLighting;
+	int lightSpaceMatrix;
+	int shadowMap;
+	int staticShadowMap;
+};
+
+static LitShaderLocs basicLocs;
+static LitShaderLocs staticLocs;
+
+// matches the frameLighting[4] uniform array, so it goes up with a single SetShaderValueV
+struct FrameLighting {
+	Vector3 lightDir;
+	Vector3 lightColor;
+	Vector3 ambientColor;
+	Vector3 shadowParams; // x = enabled, y = depth bias
+};
+
+// orthographic light fitted around what the camera can see
+struct LightFrame {
+	Matrix view;
+	Matrix projection;
+	Matrix viewProjection;
+	float depthRange;
+};
+
+// what the static shadow map was last rendered with
+static Matrix staticShadowLightSpace;
+static unsigned int staticShadowVersion = 0;
+static bool staticShadowValid = false;
+
+static const int shadowMapSlot = 10;
+static const int staticShadowMapSlot = 11;
+
+// merged mesh of one Workspace::StaticChunks entry
+struct BakedChunk {
+	Mesh mesh = {0};
+	BoundingBox bounds;
+};
+
+static std::unordered_map<uint64_t, BakedChunk> bakedChunks;
+static unsigned int bakedStaticVersion = 0;
+
+// per shape instance buffers, refilled every frame and drawn with one call each
+static std::vector<Matrix> partInstances[PART_SHAPE_COUNT][vLodCount];
+static std::vector<Matrix> shadowInstances[PART_SHAPE_COUNT];
+
 // helpers gui
 
 static Vector2 ComputeAbsoluteSize(const LuaUDim2 &size, const Vector2 &parentSize) {
@@ -82,22 +150,100 @@ Matrix MatrixRemoveScale(Matrix m) {
 	return m;
 }
 
+// blocks have nothing to simplify, every lod is the same cube
+static const Mesh &MeshFromShape(PartShape shape, int lod) {
+	switch (shape) {
+	case PART_SHAPE_BALL:
+		return meshBall[lod];
+	case PART_SHAPE_CYLINDER:
+		return meshCylinder[lod];
+	default:
+		return meshCube;
+	}
+}
+
+// depth only framebuffer, same setup as raylib's shadowmap example
+static RenderTexture LoadShadowMap(int resolution) {
+	RenderTexture target = {0};
+
+	target.id = rlLoadFramebuffer();
+	target.texture.width = resolution;
+	target.texture.height = resolution;
+
+	target.depth.id = rlLoadTextureDepth(resolution, resolution, false);
+	target.depth.width = resolution;
+	target.depth.height = resolution;
+	target.depth.mipmaps = 1;
+
+	rlFramebufferAttach(target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+
+	if (!rlFramebufferComplete(target.id))
+		printf("RENDERER: shadow map framebuffer is incomplete\n");
+
+	return target;
+}
+
+static void UnloadShadowMap(RenderTexture &target) {
+	// also frees the attached depth texture
+	if (target.id > 0) rlUnloadFramebuffer(target.id);
+	target = {0};
+}
+
+static LitShaderLocs ResolveLitShaderLocs(Shader shader) {
+	LitShaderLocs locs;
+	locs.frameLighting = GetShaderLocation(shader, "frameLighting");
+	locs.lightSpaceMatrix = GetShaderLocation(shader, "lightSpaceMatrix");
+	locs.shadowMap = GetShaderLocation(shader, "shadowMap");
+	locs.staticShadowMap = GetShaderLocation(shader, "staticShadowMap");
+
+	return locs;
+}
+
 void ReadyRenderer() {
 	rlSetClipPlanes(vMinRenderDistance, vMaxRenderDistance);
 
 	partTexture = LoadTexture("src/assets/PartTexture.png");
 
 	meshCube = GenMeshCube(1, 1, 1);
-	meshBall = GenMeshSphere(0.5, 16, 16);
-	meshCylinder = GenMeshCylinder(0.5, 1, 16);
+	for (int lod = 0; lod < vLodCount; lod++) {
+		meshBall[lod] = GenMeshSphere(0.5, vLodSegments[lod], vLodSegments[lod]);
+		meshCylinder[lod] = GenMeshCylinder(0.5, 1, vLodSegments[lod]);
+	}
 
 	material = LoadMaterialDefault();
 	material.maps[MATERIAL_MAP_ALBEDO].color = WHITE;
+	material.maps[MATERIAL_MAP_DIFFUSE].texture = partTexture;
 
-	gBasicShader = LoadShaderFromMemory(GLSL_BASIC_VERT, GLSL_BASIC_FRAG);
+	gBasicShader = LoadShaderFromMemory(GLSL_BASIC_INSTANCED_VERT, GLSL_BASIC_FRAG);
 	gBasicShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(gBasicShader, "viewPos");
+	gBasicShader.locs[SHADER_LOC_VERTEX_INSTANCE_TX] = GetShaderLocationAttrib(gBasicShader, "instanceTransform");
+
+	basicLocs = ResolveLitShaderLocs(gBasicShader);
+
+	gStaticShader = LoadShaderFromMemory(GLSL_STATIC_VERT, GLSL_BASIC_FRAG);
+	staticLocs = ResolveLitShaderLocs(gStaticShader);
+
+	staticMaterial = LoadMaterialDefault();
+	staticMaterial.shader = gStaticShader;
+	staticMaterial.maps[MATERIAL_MAP_DIFFUSE].texture = partTexture;
+
+	gDepthShader = LoadShaderFromMemory(GLSL_DEPTH_INSTANCED_VERT, GLSL_DEPTH_FRAG);
+	gDepthShader.locs[SHADER_LOC_VERTEX_INSTANCE_TX] = GetShaderLocationAttrib(gDepthShader, "instanceTransform");
+
+	depthMaterial = LoadMaterialDefault();
+	depthMaterial.shader = gDepthShader;
+
+	gStaticDepthShader = LoadShaderFromMemory(GLSL_DEPTH_VERT, GLSL_DEPTH_FRAG);
 
-	gTextureShader = LoadShaderFromMemory(GLSL_TEXTURE_VERT, GLSL_TEXTURE_FRAG);
+	staticDepthMaterial = LoadMaterialDefault();
+	staticDepthMaterial.shader = gStaticDepthShader;
+
+	shadowMap = LoadShadowMap(vShadowResolution);
+	staticShadowMap = LoadShadowMap(vShadowResolution);
+	staticShadowValid = false;
+
+	// never changes, so it is set once here instead of every frame
+	SetShaderValue(gBasicShader, GetShaderLocation(gBasicShader, "tileCount"), &textureScale, SHADER_UNIFORM_VEC2);
 
 	material.shader = gBasicShader;
 
@@ -107,9 +253,24 @@ void ReadyRenderer() {
 void UnreadyRenderer() {
 	rendererReady = false;
 	UnloadMesh(meshCube);
-	UnloadMesh(meshBall);
-	UnloadMesh(meshCylinder);
+	for (int lod = 0; lod < vLodCount; lod++) {
+		UnloadMesh(meshBall[lod]);
+		UnloadMesh(meshCylinder[lod]);
+	}
 	if (IsMaterialValid(material)) UnloadMaterial(material);
+	UnloadShadowMap(shadowMap);
+	UnloadShadowMap(staticShadowMap);
+
+	for (auto &[key, baked] : bakedChunks) {
+		UnloadMesh(baked.mesh);
+	}
+	bakedChunks.clear();
+	bakedStaticVersion = 0;
+
+	// chunks have to be rebaked if the renderer comes back
+	for (auto &[key, chunk] : gWorkspace->StaticChunks) {
+		chunk.Dirty = true;
+	}
 	//if (IsShaderValid(gBasicShader)) UnloadShader(gBasicShader);
 }
 
@@ -118,94 +279,369 @@ void EnsureRendererIsReady() {
 		ReadyRenderer();
 }
 
-bool RenderingIsTexturePass = false;
-void RenderInstance(Instance *inst) {
-	if (Part *part = dynamic_cast<Part *>(inst)) {
-		Matrix transform = MatrixScale(
-			part->Size.x,
-			part->Size.y,
-			part->Size.z
-		);
-
-		transform = MatrixMultiply(
-			transform,
-			MatrixRotateXYZ((Vector3){
-				part->Rotation.x * DEG2RAD,
-				part->Rotation.y * DEG2RAD,
-				part->Rotation.z * DEG2RAD}
-			)
-		);
-
-		transform = MatrixMultiply(
-			transform,
-			MatrixTranslate(
-				part->Position.x,
-				part->Position.y,
-				part->Position.z
-			)
-		);
-
-		if (RenderingIsTexturePass) {
-			Vector3 partSize = Vector3Scale(part->Size, 1);
-
-			SetShaderValue(gTextureShader, GetShaderLocation(gTextureShader, "partSize"), &partSize, SHADER_UNIFORM_VEC3);
-		} else {
-			material.maps[MATERIAL_MAP_ALBEDO].color = part->color;
-			Vector3 color = {
-				static_cast<float>(part->color.r) / 255.0f,
-				static_cast<float>(part->color.g) / 255.0f,
-				static_cast<float>(part->color.b) / 255.0f};
+static bool MaterialIsTextured(PartMaterial material) {
+	return material == PART_MATERIAL_PLASTIC;
+}
+
+// same matrices BeginMode3D builds for the camera
+static Matrix CameraViewProjection(const Camera3D &camera) {
+	Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+	double aspect = (double)GetScreenWidth() / (double)GetScreenHeight();
+
+	Matrix projection;
+	if (camera.projection == CAMERA_PERSPECTIVE) {
+		projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect, vMinRenderDistance, vMaxRenderDistance);
+	} else {
+		double top = camera.fovy / 2.0;
+		double right = top * aspect;
+		projection = MatrixOrtho(-right, right, -top, top, vMinRenderDistance, vMaxRenderDistance);
+	}
+
+	return MatrixMultiply(view, projection);
+}
+
+static LightFrame FitLightToCamera(const Camera3D &camera, Vector3 sunDir) {
+	// bounding sphere of the camera frustum, cut off at the shadow range
+	float range = fminf(vShadowRange, vMaxRenderDistance);
+	float aspect = (float)GetScreenWidth() / (float)GetScreenHeight();
+
+	float halfHeight = (camera.projection == CAMERA_PERSPECTIVE) ? range * tanf(camera.fovy * 0.5f * DEG2RAD) : camera.fovy * 0.5f;
+	float halfWidth = halfHeight * aspect;
+
+	Vector3 forward = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+	Vector3 center = Vector3Add(camera.position, Vector3Scale(forward, range * 0.5f));
+	float radius = sqrtf(range * range * 0.25f + halfWidth * halfWidth + halfHeight * halfHeight);
+
+	// snap the center to a coarse grid so the light only moves every so often,
+	// otherwise the static map would have to be redrawn every time the camera moves
+	float step = radius / 8.0f;
+	center.x = floorf(center.x / step + 0.5f) * step;
+	center.y = floorf(center.y / step + 0.5f) * step;
+	center.z = floorf(center.z / step + 0.5f) * step;
+	radius += step;
+
+	sunDir = Vector3Normalize(sunDir);
+	Vector3 up = (fabsf(sunDir.y) > 0.99f) ? (Vector3){0, 0, 1} : (Vector3){0, 1, 0};
+	float distance = radius + vShadowCasterDistance;
+
+	LightFrame light;
+	light.depthRange = distance + radius;
+	light.view = MatrixLookAt(Vector3Subtract(center, Vector3Scale(sunDir, distance)), center, up);
+	light.projection = MatrixOrtho(-radius, radius, -radius, radius, 0.0, light.depthRange);
+	light.viewProjection = MatrixMultiply(light.view, light.projection);
+
+	return light;
+}
+
+static void BeginShadowTarget(const RenderTexture &target, const LightFrame &light) {
+	rlEnableFramebuffer(target.id);
+	rlViewport(0, 0, vShadowResolution, vShadowResolution);
+	rlClearScreenBuffers();
+
+	rlSetMatrixProjection(light.projection);
+	rlSetMatrixModelview(light.view);
+
+	// back faces only, keeps most of the acne off lit surfaces
+	rlSetCullFace(RL_CULL_FACE_FRONT);
+}
+
+static void EndShadowTarget() {
+	rlSetCullFace(RL_CULL_FACE_BACK);
+	rlDisableFramebuffer();
+}
+
+static void DrawDynamicShadowCasters(const Frustum &lightFrustum) {
+	for (std::vector<Matrix> &instances : shadowInstances) {
+		instances.clear();
+	}
+
+	for (Part *part : gWorkspace->RenderParts) {
+		if (!FrustumContainsBox(lightFrustum, part->GetBounds())) continue;
+
+		shadowInstances[part->ShapeType].push_back(part->GetTransform());
+	}
+
+	for (int shape = 0; shape < PART_SHAPE_COUNT; shape++) {
+		std::vector<Matrix> &instances = shadowInstances[shape];
+		if (instances.empty()) continue;
+
+		DrawMeshInstanced(MeshFromShape((PartShape)shape, vShadowLod), depthMaterial, instances.data(), (int)instances.size());
+	}
+}
+
+static void DrawStaticShadowCasters(const Frustum &lightFrustum) {
+	for (auto &[key, baked] : bakedChunks) {
+		if (!FrustumContainsBox(lightFrustum, baked.bounds)) continue;
+
+		DrawMesh(baked.mesh, staticDepthMaterial, MatrixIdentity());
+	}
+}
+
+static void RenderShadowMaps(const LightFrame &light) {
+	Frustum lightFrustum = FrustumFromMatrix(light.viewProjection);
+
+	Matrix savedView = rlGetMatrixModelview();
+	Matrix savedProjection = rlGetMatrixProjection();
+
+	rlDrawRenderBatchActive();
+
+	// anchored parts are only redrawn when one of them changed or the light moved
+	bool staticDirty = !staticShadowValid ||
+		staticShadowVersion != gWorkspace->StaticVersion ||
+		memcmp(&staticShadowLightSpace, &light.viewProjection, sizeof(Matrix)) != 0;
 
-			SetShaderValue(gBasicShader, GetShaderLocation(gBasicShader, "albedoColor"), &color, SHADER_UNIFORM_VEC3);
+	if (staticDirty) {
+		BeginShadowTarget(staticShadowMap, light);
+		DrawStaticShadowCasters(lightFrustum);
+		EndShadowTarget();
+
+		staticShadowLightSpace = light.viewProjection;
+		staticShadowVersion = gWorkspace->StaticVersion;
+		staticShadowValid = true;
+	}
+
+	BeginShadowTarget(shadowMap, light);
+	DrawDynamicShadowCasters(lightFrustum);
+	EndShadowTarget();
+
+	rlViewport(0, 0, GetRenderWidth(), GetRenderHeight());
+	rlSetMatrixProjection(savedProjection);
+	rlSetMatrixModelview(savedView);
+}
+
+static void BindShadowMap(int location, const RenderTexture &target, int slot) {
+	rlActiveTextureSlot(slot);
+	rlEnableTexture(target.depth.id);
+	rlSetUniform(location, &slot, SHADER_UNIFORM_INT, 1);
+}
+
+static void UnbindShadowMaps() {
+	rlActiveTextureSlot(shadowMapSlot);
+	rlDisableTexture();
+	rlActiveTextureSlot(staticShadowMapSlot);
+	rlDisableTexture();
+	rlActiveTextureSlot(0);
+}
+
+// merges every part of a chunk into one non indexed world space mesh,
+// with the same attributes the instanced shader derives per vertex
+static BakedChunk BakeStaticChunk(const StaticChunk &chunk) {
+	std::vector<float> vertices;
+	std::vector<float> normals;
+	std::vector<float> texcoords;
+	std::vector<unsigned char> colors;
+
+	BakedChunk baked;
+	baked.bounds = chunk.Parts[0]->GetBounds();
+
+	for (Part *part : chunk.Parts) {
+		baked.bounds = BoxUnion(baked.bounds, part->GetBounds());
+
+		const Mesh &source = MeshFromShape(part->ShapeType, 0);
+		const Matrix &transform = part->GetTransform();
+		Matrix normalMatrix = MatrixTranspose(MatrixInvert(transform));
+
+		unsigned char textured = MaterialIsTextured(part->MaterialType) ? 255 : 0;
+		int count = source.indices ? source.triangleCount * 3 : source.vertexCount;
+
+		for (int i = 0; i < count; i++) {
+			int v = source.indices ? source.indices[i] : i;
+
+			Vector3 local = {source.vertices[v * 3], source.vertices[v * 3 + 1], source.vertices[v * 3 + 2]};
+			Vector3 normal = {source.normals[v * 3], source.normals[v * 3 + 1], source.normals[v * 3 + 2]};
+
+			Vector3 position = Vector3Transform(local, transform);
+			Vector3 worldNormal = Vector3Normalize(Vector3Transform(normal, normalMatrix));
+
+			// same face projection as GLSL_BASIC_INSTANCED_VERT
+			Vector2 uv;
+			if (fabsf(normal.x) > 0.5f)
+				uv = {local.y * part->Size.y, local.z * part->Size.z};
+			else if (fabsf(normal.y) > 0.5f)
+				uv = {local.x * part->Size.x, local.z * part->Size.z};
+			else
+				uv = {local.x * part->Size.x, local.y * part->Size.y};
+
+			vertices.insert(vertices.end(), {position.x, position.y, position.z});
+			normals.insert(normals.end(), {worldNormal.x, worldNormal.y, worldNormal.z});
+			texcoords.insert(texcoords.end(), {uv.x * textureScale.x, uv.y * textureScale.y});
+			colors.insert(colors.end(), {part->color.r, part->color.g, part->color.b, textured});
 		}
+	}
+
+	// UnloadMesh frees these with RL_FREE, so they have to come from MemAlloc
+	Mesh &mesh = baked.mesh;
+	mesh.vertexCount = (int)(vertices.size() / 3);
+	mesh.triangleCount = mesh.vertexCount / 3;
+
+	mesh.vertices = (float *)MemAlloc((unsigned int)(vertices.size() * sizeof(float)));
+	mesh.normals = (float *)MemAlloc((unsigned int)(normals.size() * sizeof(float)));
+	mesh.texcoords = (float *)MemAlloc((unsigned int)(texcoords.size() * sizeof(float)));
+	mesh.colors = (unsigned char *)MemAlloc((unsigned int)colors.size());
+
+	memcpy(mesh.vertices, vertices.data(), vertices.size() * sizeof(float));
+	memcpy(mesh.normals, normals.data(), normals.size() * sizeof(float));
+	memcpy(mesh.texcoords, texcoords.data(), texcoords.size() * sizeof(float));
+	memcpy(mesh.colors, colors.data(), colors.size());
+
+	UploadMesh(&mesh, false);
+	return baked;
+}
+
+// rebakes dirty chunks and drops the ones Workspace no longer has
+static void SyncStaticChunks() {
+	if (bakedStaticVersion == gWorkspace->StaticVersion) return;
+
+	for (auto it = bakedChunks.begin(); it != bakedChunks.end();) {
+		if (gWorkspace->StaticChunks.count(it->first) == 0) {
+			UnloadMesh(it->second.mesh);
+			it = bakedChunks.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto &[key, chunk] : gWorkspace->StaticChunks) {
+		if (!chunk.Dirty) continue;
+
+		auto existing = bakedChunks.find(key);
+		if (existing != bakedChunks.end())
+			UnloadMesh(existing->second.mesh);
+
+		bakedChunks[key] = BakeStaticChunk(chunk);
+		chunk.Dirty = false;
+	}
+
+	bakedStaticVersion = gWorkspace->StaticVersion;
+}
+
+static void DrawStaticChunks(const Frustum &frustum) {
+	for (auto &[key, baked] : bakedChunks) {
+		if (!FrustumContainsBox(frustum, baked.bounds)) continue;
+
+		DrawMesh(baked.mesh, staticMaterial, MatrixIdentity());
+	}
+}
 
-		if (part->Shape == "Ball") {
-			DrawMesh(meshBall, material, transform);
-		} else if (part->Shape == "Cylinder") {
-			DrawMesh(meshCylinder, material, transform);
+static void ApplyLitUniforms(Shader shader, const LitShaderLocs &locs, const FrameLighting &lighting, const LightFrame *light) {
+	SetShaderValueV(shader, locs.frameLighting, &lighting, SHADER_UNIFORM_VEC3, 4);
+
+	if (light) {
+		SetShaderValueMatrix(shader, locs.lightSpaceMatrix, light->viewProjection);
+
+		// rlSetUniform needs the program bound, SetShaderValue does this internally
+		rlEnableShader(shader.id);
+		BindShadowMap(locs.shadowMap, shadowMap, shadowMapSlot);
+		BindShadowMap(locs.staticShadowMap, staticShadowMap, staticShadowMapSlot);
+	}
+}
+
+// only crosses a threshold once the size is clearly past it, so parts near one do not flicker
+static int SelectLod(int current, float pixelRadius) {
+	int lod = current;
+
+	while (lod > 0 && pixelRadius > vLodPixelRadius[lod - 1] * (1.0f + vLodHysteresis))
+		lod--;
+
+	while (lod < vLodCount - 1 && pixelRadius < vLodPixelRadius[lod] * (1.0f - vLodHysteresis))
+		lod++;
+
+	return lod;
+}
+
+static void GatherPartInstances(const Camera3D &camera, const Frustum &frustum) {
+	// pixels per world unit at distance 1 (perspective) or anywhere (orthographic)
+	float pixelScale = (float)GetScreenHeight() * 0.5f;
+	if (camera.projection == CAMERA_PERSPECTIVE)
+		pixelScale /= tanf(camera.fovy * 0.5f * DEG2RAD);
+	else
+		pixelScale /= camera.fovy * 0.5f;
+
+	for (Part *part : gWorkspace->RenderParts) {
+		const BoundingBox &bounds = part->GetBounds();
+		if (!FrustumContainsBox(frustum, bounds)) continue;
+
+		if (part->ShapeType != PART_SHAPE_BLOCK) {
+			Vector3 center = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5f);
+			float radius = Vector3Distance(bounds.min, bounds.max) * 0.5f;
+
+			float pixelRadius = radius * pixelScale;
+			if (camera.projection == CAMERA_PERSPECTIVE)
+				pixelRadius /= fmaxf(Vector3Distance(camera.position, center), vMinRenderDistance);
+
+			part->lodLevel = SelectLod(part->lodLevel, pixelRadius);
 		} else {
-			DrawMesh(meshCube, material, transform);
+			// blocks only have one mesh, a part that used to be a ball or cylinder keeps its old level otherwise
+			part->lodLevel = 0;
 		}
+
+		Matrix transform = part->GetTransform();
+
+		// bottom row is unused by an affine transform, the instanced shader reads the albedo
+		// and whether to apply the part texture from it
+		transform.m3 = static_cast<float>(part->color.r) / 255.0f;
+		transform.m7 = static_cast<float>(part->color.g) / 255.0f;
+		transform.m11 = static_cast<float>(part->color.b) / 255.0f;
+		transform.m15 = MaterialIsTextured(part->MaterialType) ? 1.0f : 0.0f;
+
+		partInstances[part->ShapeType][part->lodLevel].push_back(transform);
 	}
+}
 
-	for (Instance *child : inst->Children) {
-		RenderInstance(child);
+static void DrawPartInstances() {
+	for (int shape = 0; shape < PART_SHAPE_COUNT; shape++) {
+		for (int lod = 0; lod < vLodCount; lod++) {
+			std::vector<Matrix> &instances = partInstances[shape][lod];
+			if (instances.empty()) continue;
+
+			DrawMeshInstanced(MeshFromShape((PartShape)shape, lod), material, instances.data(), (int)instances.size());
+		}
 	}
 }
 
-void RenderWorkspace() {
-	Vector3 sunDir = SunDirFromClock(gLighting->ClockTime);
-	Vector3 lightColor = {1.0f, 1.0f, 1.0f};
-	Vector3 ambient = {0.5f, 0.5f, 0.5f};
+void RenderWorkspace(const Camera3D &camera) {
+	Frustum frustum = FrustumFromMatrix(CameraViewProjection(camera));
 
-	Matrix lightView = MatrixLookAt(Vector3Scale(sunDir, -20.f), Vector3Zero(), {0, 1, 0});
-	Matrix lightProjection = MatrixOrtho(-20, 20, -20, 20, 1.f, 100.f);
-	Matrix lightSpaceMatrix = MatrixMultiply(lightProjection, lightView);
+	bool shadows = gLighting->GlobalShadows;
+
+	FrameLighting lighting;
+	lighting.lightDir = SunDirFromClock(gLighting->ClockTime);
+	lighting.lightColor = {1.0f, 1.0f, 1.0f};
+	lighting.ambientColor = {0.5f, 0.5f, 0.5f};
+	lighting.shadowParams = {0.0f, 0.0f, 0.0f};
+
+	SyncStaticChunks();
+
+	LightFrame light;
+	if (shadows) {
+		light = FitLightToCamera(camera, lighting.lightDir);
+		lighting.shadowParams = {1.0f, vShadowBias / light.depthRange, 0.0f};
+
+		RenderShadowMaps(light);
+	}
+
+	for (auto &lods : partInstances) {
+		for (std::vector<Matrix> &instances : lods) {
+			instances.clear();
+		}
+	}
+
+	GatherPartInstances(camera, frustum);
 
 	// Color pass
 	material.shader = gBasicShader;
 
-	RenderingIsTexturePass = false;
 	BeginShaderMode(gBasicShader);
-	SetShaderValue(gBasicShader, GetShaderLocation(gBasicShader, "lightDir"), &sunDir, SHADER_UNIFORM_VEC3);
-	SetShaderValue(gBasicShader, GetShaderLocation(gBasicShader, "lightColor"), &lightColor, SHADER_UNIFORM_VEC3);
-	SetShaderValue(gBasicShader, GetShaderLocation(gBasicShader, "ambientColor"), &ambient, SHADER_UNIFORM_VEC3);
+	ApplyLitUniforms(gBasicShader, basicLocs, lighting, shadows ? &light : nullptr);
+	DrawPartInstances();
+	EndShaderMode();
 
-	RenderInstance(gWorkspace);
+	BeginShaderMode(gStaticShader);
+	ApplyLitUniforms(gStaticShader, staticLocs, lighting, shadows ? &light : nullptr);
+	DrawStaticChunks(frustum);
 	EndShaderMode();
 
-	// Texture pass
-	if (vDoTexturePass) {
-		material.shader = gTextureShader;
-		material.maps[MATERIAL_MAP_DIFFUSE].texture = partTexture;
-
-		RenderingIsTexturePass = true;
-		BeginShaderMode(gTextureShader);
-		SetShaderValueTexture(gTextureShader, GetShaderLocation(gTextureShader, "texture0"), partTexture);
-		SetShaderValue(gTextureShader, GetShaderLocation(gTextureShader, "tileCount"), &textureScale, SHADER_UNIFORM_VEC2);
-		RenderInstance(gWorkspace);
-		EndShaderMode();
-	}
+	if (shadows) UnbindShadowMaps();
 }
 
 void RenderGuiObject(GuiObject *object, const Vector2 &parentPos, const Vector2 &parentSize) {
@@ -9,6 +9,5 @@ void ReadyRenderer();
 void UnreadyRenderer();
 void EnsureRendererIsReady();
 
-void RenderInstance(Instance* inst);
-void RenderWorkspace();
+void RenderWorkspace(const Camera3D& camera);
 void RenderGui();
\ No newline at end of file
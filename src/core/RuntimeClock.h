@@ -0,0 +1,19 @@
+#pragma once
+
+#include <raylib.h>
+
+// time source for the scheduler and services, reads the wall clock while windowed
+// headless runs advance it by a fixed tick so they are reproducible
+struct RuntimeClock {
+	bool fixedStep = false;
+	double time = 0.0;
+};
+
+extern RuntimeClock gRuntimeClock;
+
+static double GetRuntimeTime() {
+	if (gRuntimeClock.fixedStep)
+		return gRuntimeClock.time;
+
+	return GetTime();
+}
@@ -9,6 +9,7 @@
 #include "lualib.h"
 
 #include "LuaScheduler.h"
+#include "RuntimeClock.h"
 
 #include "datatypes/LuaVector2.h"
 #include "datatypes/LuaVector3.h"
@@ -17,6 +18,7 @@
 #include "datatypes/LuaSignal.h"
 #include "datatypes/LuaRandom.h"
 #include "datatypes/LuaAxes.h"
+#include "datatypes/LuaCFrame.h"
 
 #include "objects/Frame.h"
 #include "objects/Instance.h"
@@ -57,7 +59,7 @@ static int l_Instance_new(lua_State* L) {
 }
 
 static int l_Time(lua_State* L) {
-	lua_pushnumber(L, GetTime());
+	lua_pushnumber(L, GetRuntimeTime());
 	return 1;
 }
 
@@ -107,6 +109,7 @@ void SetScriptingAPI(lua_State* L) {
 	RegisterSignal(L);
 	RegisterRandom(L);
 	RegisterAxes(L);
+	RegisterCFrame(L);
 
 	PushInstance(L, gGame); lua_setglobal(L, "game");
 	PushInstance(L, gGame); lua_setglobal(L, "Game");
@@ -9,6 +9,8 @@
 #include "lualib.h"
 #include "luacode.h"
 
+#include "utils/LuaTags.h"
+
 #define LUA_AXES "LuaAxes"
 
 struct LuaAxes {
@@ -17,14 +19,12 @@ struct LuaAxes {
 };
 
 static LuaAxes* CheckAxes(lua_State* L, int idx) {
-	return static_cast<LuaAxes*>(luaL_checkudata(L, idx, LUA_AXES));
+	return static_cast<LuaAxes*>(CheckUserdataTagged(L, idx, LUA_TAG_AXES, "Axes"));
 }
 
 static void PushAxes(lua_State* L, bool x, bool y, bool z, bool top, bool bottom, bool left, bool right, bool back, bool front) {
-	LuaAxes* c = (LuaAxes*)lua_newuserdata(L, sizeof(LuaAxes));
+	LuaAxes* c = (LuaAxes*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaAxes), LUA_TAG_AXES);
 
-	luaL_getmetatable(L, LUA_AXES);
-	lua_setmetatable(L, -2);
 }
 
 static void PushAxes(lua_State* L, bool x, bool y, bool z) {
@@ -71,7 +71,7 @@ static int l_Axes_new(lua_State* L) {
 static void RegisterAxes(lua_State* L) {
 	luaL_newmetatable(L, LUA_AXES);
 		lua_pushcfunction(L, l_Axes_index, "Axes.__index"); lua_setfield(L, -2, "__index");
-	lua_pop(L,1);
+	lua_setuserdatametatable(L, LUA_TAG_AXES);
 
 	lua_newtable(L);
 		lua_pushcfunction(L, l_Axes_new, "Axes.new"); lua_setfield(L, -2, "new");
@@ -10,6 +10,8 @@
 #include "lualib.h"
 #include "luacode.h"
 
+#include "utils/LuaTags.h"
+
 #define LUA_CFRAME "LuaCFrame"
 
 struct LuaCFrame {
@@ -17,15 +19,13 @@ struct LuaCFrame {
 };
 
 static LuaCFrame* CheckCFrame(lua_State* L, int idx) {
-	return static_cast<LuaCFrame*>(luaL_checkudata(L, idx, LUA_CFRAME));
+	return static_cast<LuaCFrame*>(CheckUserdataTagged(L, idx, LUA_TAG_CFRAME, "CFrame"));
 }
 
 static void PushCFrame(lua_State* L, const Matrix& m) {
-	LuaCFrame* c = (LuaCFrame*)lua_newuserdata(L, sizeof(LuaCFrame));
+	LuaCFrame* c = (LuaCFrame*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaCFrame), LUA_TAG_CFRAME);
 	c->m = m;
 
-	luaL_getmetatable(L, LUA_CFRAME);
-	lua_setmetatable(L, -2);
 }
 
 static Matrix CFrameIdentity() {
@@ -158,15 +158,15 @@ static int l_CFrame_new(lua_State* L) {
 		return 1;
 	}
 
-	if (argc == 1 && luaL_checkudata(L, 1, LUA_VECTOR3)) {
+	if (argc == 1 && CheckVector3(L, 1)) {
 		Vector3 p = RaylibVector3FromLuaVector3(*CheckVector3(L, 1));
 		PushCFrame(L, MatrixTranslate(p.x, p.y, p.z));
 		return 1;
 	}
 
 	if (argc == 2 &&
-		luaL_checkudata(L, 1, LUA_VECTOR3) &&
-		luaL_checkudata(L, 2, LUA_VECTOR3)) {
+		CheckVector3(L, 1) &&
+		CheckVector3(L, 2)) {
 			
 		Vector3 pos = RaylibVector3FromLuaVector3(*CheckVector3(L, 1));
 		Vector3 target = RaylibVector3FromLuaVector3(*CheckVector3(L, 2));
@@ -207,8 +207,8 @@ static int l_CFrame_lookAt(lua_State* L) {
 
 static void RegisterCFrame(lua_State* L) {
 	luaL_newmetatable(L, LUA_CFRAME);
-
-	lua_pop(L,1);
+		lua_pushcfunction(L, l_CFrame_index, "CFrame.__index"); lua_setfield(L, -2, "__index");
+	lua_setuserdatametatable(L, LUA_TAG_CFRAME);
 
 	lua_newtable(L); // CFrame
 		lua_pushcfunction(L, l_CFrame_new, "CFrame.new"); lua_setfield(L, -2, "new");
@@ -8,6 +8,8 @@
 #include "luacode.h"
 
 #include "utils/ExtraMath.h"
+#include "utils/LuaAtoms.h"
+#include "utils/LuaTags.h"
 
 #define LUA_COLOR3 "LuaColor3"
 
@@ -18,17 +20,15 @@ struct LuaColor3 {
 };
 
 static LuaColor3* CheckColor3(lua_State* L, int idx) {
-    return (LuaColor3*)luaL_checkudata(L, idx, LUA_COLOR3);
+    return static_cast<LuaColor3*>(CheckUserdataTagged(L, idx, LUA_TAG_COLOR3, "Color3"));
 }
 
 static void PushColor3(lua_State* L, float r, float g, float b) {
-    LuaColor3* c = (LuaColor3*)lua_newuserdata(L, sizeof(LuaColor3));
+    LuaColor3* c = (LuaColor3*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaColor3), LUA_TAG_COLOR3);
     c->r = r; 
 	c->g = g; 
 	c->b = b;
 
-    luaL_getmetatable(L, LUA_COLOR3);
-    lua_setmetatable(L, -2);
 }
 
 static int l_Color3_Lerp(lua_State* L) {
@@ -45,6 +45,17 @@ static int l_Color3_Lerp(lua_State* L) {
 	return 1;
 }
 
+static int l_Color3_namecall(lua_State* L) {
+	int atom = -1;
+	const char* name = lua_namecallatom(L, &atom);
+
+	if (atom == ATOM_Lerp)
+		return l_Color3_Lerp(L);
+
+	luaL_error(L, "%s is not a valid method of Color3", name ? name : "?");
+	return 0;
+}
+
 static int l_Color3_index(lua_State* L) {
     LuaColor3* c = CheckColor3(L, 1);
     const char* key = luaL_checkstring(L, 2);
@@ -94,9 +105,10 @@ static int l_Color3_fromRGB(lua_State* L) {
 static void RegisterColor3(lua_State* L) {
 	luaL_newmetatable(L, LUA_COLOR3);
 		lua_pushcfunction(L, l_Color3_index, "Color3.__index"); lua_setfield(L, -2, "__index");
+		lua_pushcfunction(L, l_Color3_namecall, "Color3.__namecall"); lua_setfield(L, -2, "__namecall");
 		lua_pushcfunction(L, l_Color3_add, "Color3.__add"); lua_setfield(L, -2, "__add");
 		lua_pushcfunction(L, l_Color3_sub, "Color3.__sub"); lua_setfield(L, -2, "__sub");
-	lua_pop(L,1);
+	lua_setuserdatametatable(L, LUA_TAG_COLOR3);
 
 	lua_newtable(L); // Color3
 		lua_pushcfunction(L, l_Color3_new, "new"); lua_setfield(L, -2, "new");
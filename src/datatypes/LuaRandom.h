@@ -8,6 +8,8 @@
 #include "luacode.h"
 
 #include "datatypes/LuaVector3.h"
+#include "utils/LuaAtoms.h"
+#include "utils/LuaTags.h"
 #include "raylib.h"
 #include "raymath.h"
 
@@ -21,28 +23,24 @@ struct LuaRandom {
 };
 
 static LuaRandom* CheckRandom(lua_State* L, int idx) {
-	return (LuaRandom*)luaL_checkudata(L, idx, LUA_RANDOM);
+	return static_cast<LuaRandom*>(CheckUserdataTagged(L, idx, LUA_TAG_RANDOM, "Random"));
 }
 
 static void PushRandom(lua_State* L, std::mt19937 rng, double seed) {
-	LuaRandom* r = (LuaRandom*)lua_newuserdata(L, sizeof(LuaRandom));
+	LuaRandom* r = (LuaRandom*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaRandom), LUA_TAG_RANDOM);
 	r->rng = rng;
 	r->seed = seed;
 
 	r->rng.seed(static_cast<uint32_t>(seed));
 
-	luaL_getmetatable(L, LUA_RANDOM);
-	lua_setmetatable(L, -2);
 }
 
 static void PushRandom(lua_State* L, double seed) {
-	LuaRandom* r = (LuaRandom*)lua_newuserdata(L, sizeof(LuaRandom));
+	LuaRandom* r = (LuaRandom*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaRandom), LUA_TAG_RANDOM);
 	r->seed = seed;
 
 	r->rng.seed(static_cast<uint32_t>(seed));
 
-	luaL_getmetatable(L, LUA_RANDOM);
-	lua_setmetatable(L, -2);
 }
 
 static int l_Random_NextNumber(lua_State* L) {
@@ -121,6 +119,22 @@ static int l_Random_Clone(lua_State* L) {
 	return 1;
 }
 
+static int l_Random_namecall(lua_State* L) {
+	int atom = -1;
+	const char* name = lua_namecallatom(L, &atom);
+
+	switch (atom) {
+		case ATOM_NextNumber: return l_Random_NextNumber(L);
+		case ATOM_NextInteger: return l_Random_NextInteger(L);
+		case ATOM_Shuffle: return l_Random_Shuffle(L);
+		case ATOM_NextUnitVector: return l_Random_NextUnitVector(L);
+		case ATOM_Clone: return l_Random_Clone(L);
+	}
+
+	luaL_error(L, "%s is not a valid method of Random", name ? name : "?");
+	return 0;
+}
+
 static int l_Random_index(lua_State* L) {
 	LuaRandom* r = CheckRandom(L, 1);
 	const char* key = luaL_checkstring(L, 2);
@@ -163,7 +177,8 @@ static int l_Random_new(lua_State* L) {
 static void RegisterRandom(lua_State* L) {
 	luaL_newmetatable(L, LUA_RANDOM);
 		lua_pushcfunction(L, l_Random_index, "Random.__index"); lua_setfield(L, -2, "__index");
-	lua_pop(L, 1);
+		lua_pushcfunction(L, l_Random_namecall, "Random.__namecall"); lua_setfield(L, -2, "__namecall");
+	lua_setuserdatametatable(L, LUA_TAG_RANDOM);
 
 	lua_newtable(L);
 		lua_pushcfunction(L, l_Random_new, "Random.new"); lua_setfield(L, -2, "new");
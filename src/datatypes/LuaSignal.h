@@ -11,6 +11,10 @@
 #include "lualib.h"
 #include "luacode.h"
 
+#include "core/LuaScheduler.h"
+#include "utils/LuaAtoms.h"
+#include "utils/LuaTags.h"
+
 #define LUA_SIGNAL "LuaSignal"
 #define LUA_CONNECTION "LuaConnection"
 
@@ -20,16 +24,21 @@ struct LuaSignal {
 		int callbackRef = LUA_NOREF;
 		bool connected = true;
 		bool once = false;
+
+		// script that connected it, its time limits and overruns are counted under this
+		std::string source;
 	};
 
 	lua_State* Lm;
 	std::vector<Listener> listeners;
 
 	explicit LuaSignal(lua_State* mainState) : Lm(mainState) {}
+	// runs from the userdata destructor, inside the GC or lua_close where the Lua API can't be
+	// used, so the refs are released by the scheduler's next Step instead
 	~LuaSignal() {
 		for (auto& l : listeners) {
 			if (l.callbackRef != LUA_NOREF) {
-				lua_unref(Lm, l.callbackRef);
+				gLuaScheduler.releasedRefs.push_back(l.callbackRef);
 			}
 		}
 	}
@@ -47,7 +56,7 @@ struct LuaSignal {
 				lua_xmove(src, Lm, 1);
 			}
 
-			if (lua_pcall(Lm, argc, 0, 0) != LUA_OK) {
+			if (PCallWithBudget(gLuaScheduler, Lm, argc, l.source) != LUA_OK) {
 				const char* err = lua_tostring(Lm, -1);
 				printf("Signal Error: %s\n", err);
 				lua_pop(Lm, 1);
@@ -78,20 +87,17 @@ struct LuaSignalUD {
 };
 
 inline LuaSignalUD* CheckSignal(lua_State* L, int idx) {
-	return static_cast<LuaSignalUD*>(luaL_checkudata(L, idx, LUA_SIGNAL));
+	return static_cast<LuaSignalUD*>(CheckUserdataTagged(L, idx, LUA_TAG_SIGNAL, "Signal"));
 }
 
 inline void PushSignal(lua_State* L, std::shared_ptr<LuaSignal> sig) {
-	void* mem = lua_newuserdata(L, sizeof(LuaSignalUD));
+	void* mem = lua_newuserdatataggedwithmetatable(L, sizeof(LuaSignalUD), LUA_TAG_SIGNAL);
 	new (mem) LuaSignalUD{ sig };
-	luaL_getmetatable(L, LUA_SIGNAL);
-	lua_setmetatable(L, -2);
 }
 
-static int l_Signal_gc(lua_State* L) {
-	auto* ud = CheckSignal(L, 1);
-	if (ud) ud->~LuaSignalUD();
-	return 0;
+// Luau doesn't run __gc, the VM calls this when a signal userdata is collected
+static void SignalDestructor(lua_State* L, void* data) {
+	static_cast<LuaSignalUD*>(data)->~LuaSignalUD();
 }
 
 static int l_Signal_Connect(lua_State* L) {
@@ -101,17 +107,20 @@ static int l_Signal_Connect(lua_State* L) {
 	lua_pushvalue(L, 2);
 	lua_xmove(L, ud->sig->Lm, 1);
 	int ref = lua_ref(ud->sig->Lm, -1);
+	lua_pop(ud->sig->Lm, 1);
+
+	// also set inside coroutines made by scripts and inside other signal handlers
+	LuaThread* thread = gLuaScheduler.current;
 
 	ud->sig->listeners.push_back({
 		.callbackRef = ref,
 		.connected = true,
-		.once = false
+		.once = false,
+		.source = thread ? thread->source : "signal"
 	});
 
-	void* mem = lua_newuserdata(L, sizeof(int));
+	void* mem = lua_newuserdatatagged(L, sizeof(int), LUA_TAG_CONNECTION);
 	new (mem) int(ref);
-	luaL_getmetatable(L, LUA_CONNECTION);
-	lua_setmetatable(L, -2);
 
 	return 1;
 }
@@ -123,6 +132,19 @@ static int l_Signal_Fire(lua_State* L) {
 	return 0;
 }
 
+static int l_Signal_namecall(lua_State* L) {
+	int atom = -1;
+	const char* name = lua_namecallatom(L, &atom);
+
+	switch (atom) {
+		case ATOM_Connect: return l_Signal_Connect(L);
+		case ATOM_Fire: return l_Signal_Fire(L);
+	}
+
+	luaL_error(L, "%s is not a valid method of Signal", name ? name : "?");
+	return 0;
+}
+
 static int l_Signal_index(lua_State* L) {
 	auto* ud = CheckSignal(L, 1);
 	const char* key = luaL_checkstring(L, 2);
@@ -143,11 +165,9 @@ static int l_Signal_index(lua_State* L) {
 static int l_Signal_new(lua_State* L) {
 	auto sig = std::make_shared<LuaSignal>(L);
 
-	void* mem = lua_newuserdata(L, sizeof(LuaSignalUD));
+	void* mem = lua_newuserdatataggedwithmetatable(L, sizeof(LuaSignalUD), LUA_TAG_SIGNAL);
 	new (mem) LuaSignalUD{ sig };
 
-	luaL_getmetatable(L, LUA_SIGNAL);
-	lua_setmetatable(L, -2);
 	return 1;
 }
 
@@ -166,8 +186,9 @@ inline void FireSignal(const std::shared_ptr<LuaSignal>& sig, std::function<void
 static void RegisterSignal(lua_State* L) {
 	luaL_newmetatable(L, LUA_SIGNAL);
 		lua_pushcfunction(L, l_Signal_index, "__index"); lua_setfield(L, -2, "__index");
-		lua_pushcfunction(L, l_Signal_gc, "__gc"); lua_setfield(L, -2, "__gc");
-	lua_pop(L, 1);
+		lua_pushcfunction(L, l_Signal_namecall, "__namecall"); lua_setfield(L, -2, "__namecall");
+	lua_setuserdatametatable(L, LUA_TAG_SIGNAL);
+	lua_setuserdatadtor(L, LUA_TAG_SIGNAL, SignalDestructor);
 
 	lua_newtable(L);
 		lua_pushcfunction(L, l_Signal_new, "new"); lua_setfield(L, -2, "new");
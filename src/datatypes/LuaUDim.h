@@ -6,6 +6,9 @@
 #include "lualib.h"
 #include "luacode.h"
 
+#include "utils/LuaAtoms.h"
+#include "utils/LuaTags.h"
+
 // both UDim's are included here cuz why not (cuz chatgpt said so)
 
 #define LUA_UDIM  "LuaUDim"
@@ -24,31 +27,27 @@ struct LuaUDim2 {
 // Helper: UDim
 
 static LuaUDim* CheckUDim(lua_State* L, int idx) {
-    return (LuaUDim*)luaL_checkudata(L, idx, LUA_UDIM);
+    return static_cast<LuaUDim*>(CheckUserdataTagged(L, idx, LUA_TAG_UDIM, "UDim"));
 }
 
 static void PushUDim(lua_State* L, float scale, float offset) {
-    LuaUDim* u = (LuaUDim*)lua_newuserdata(L, sizeof(LuaUDim));
+    LuaUDim* u = (LuaUDim*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaUDim), LUA_TAG_UDIM);
     u->scale = scale;
     u->offset = offset;
 
-    luaL_getmetatable(L, LUA_UDIM);
-    lua_setmetatable(L, -2);
 }
 
 // Helper: UDim2
 
 static LuaUDim2* CheckUDim2(lua_State* L, int idx) {
-    return (LuaUDim2*)luaL_checkudata(L, idx, LUA_UDIM2);
+    return static_cast<LuaUDim2*>(CheckUserdataTagged(L, idx, LUA_TAG_UDIM2, "UDim2"));
 }
 
 static void PushUDim2(lua_State* L, LuaUDim x, LuaUDim y) {
-    LuaUDim2* u = (LuaUDim2*)lua_newuserdata(L, sizeof(LuaUDim2));
+    LuaUDim2* u = (LuaUDim2*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaUDim2), LUA_TAG_UDIM2);
     u->x = x;
     u->y = y;
 
-    luaL_getmetatable(L, LUA_UDIM2);
-    lua_setmetatable(L, -2);
 }
 
 // UDim stuff
@@ -137,6 +136,17 @@ static int l_UDim2_tostring(lua_State* L) {
 	return 1;
 }
 
+static int l_UDim2_namecall(lua_State* L) {
+	int atom = -1;
+	const char* name = lua_namecallatom(L, &atom);
+
+	if (atom == ATOM_Lerp)
+		return l_UDim2_Lerp(L);
+
+	luaL_error(L, "%s is not a valid method of UDim2", name ? name : "?");
+	return 0;
+}
+
 static int l_UDim2_index(lua_State* L) {
     auto* u = CheckUDim2(L, 1);
     const char* key = luaL_checkstring(L, 2);
@@ -192,7 +202,7 @@ static void RegisterUDim(lua_State* L) {
     lua_pushcfunction(L, l_UDim_sub, "sub"); lua_setfield(L, -2, "__sub");
 	lua_pushcfunction(L, l_UDim_tostring, "tostring"); lua_setfield(L, -2, "__tostring");
 
-    lua_pop(L, 1);
+    lua_setuserdatametatable(L, LUA_TAG_UDIM);
 
 	lua_newtable(L); // UDim
     lua_pushcfunction(L, l_UDim_new, "new"); lua_setfield(L, -2, "new");
@@ -202,10 +212,11 @@ static void RegisterUDim(lua_State* L) {
 static void RegisterUDim2(lua_State* L) {
 	luaL_newmetatable(L, LUA_UDIM2);
 		lua_pushcfunction(L, l_UDim2_index, "index"); lua_setfield(L, -2, "__index");
+		lua_pushcfunction(L, l_UDim2_namecall, "namecall"); lua_setfield(L, -2, "__namecall");
 		lua_pushcfunction(L, l_UDim2_add, "add"); lua_setfield(L, -2, "__add");
 		lua_pushcfunction(L, l_UDim2_sub, "sub"); lua_setfield(L, -2, "__sub");
 		lua_pushcfunction(L, l_UDim2_tostring, "tostring"); lua_setfield(L, -2, "__tostring");
-	lua_pop(L, 1);
+	lua_setuserdatametatable(L, LUA_TAG_UDIM2);
 
 	lua_newtable(L);
 		lua_pushcfunction(L, l_UDim2_new, "new"); lua_setfield(L, -2, "new");
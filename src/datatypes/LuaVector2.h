@@ -9,6 +9,8 @@
 #include "luacode.h"
 
 #include "utils/ExtraMath.h"
+#include "utils/LuaAtoms.h"
+#include "utils/LuaTags.h"
 
 #define LUA_VECTOR2 "LuaVector2"
 
@@ -17,15 +19,13 @@ struct LuaVector2 {
 };
 
 static LuaVector2* CheckVector2(lua_State* L, int idx) {
-	return (LuaVector2*)luaL_checkudata(L, idx, LUA_VECTOR2);
+	return static_cast<LuaVector2*>(CheckUserdataTagged(L, idx, LUA_TAG_VECTOR2, "Vector2"));
 }
 
 static int PushVector2(lua_State* L, float x, float y) {
-	auto* v = (LuaVector2*)lua_newuserdata(L, sizeof(LuaVector2));
+	auto* v = (LuaVector2*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaVector2), LUA_TAG_VECTOR2);
 	v->x = x;
 	v->y = y;
-	luaL_getmetatable(L, LUA_VECTOR2);
-	lua_setmetatable(L, -2);
 	return 1;
 }
 
@@ -37,12 +37,10 @@ static int l_Vector2_new(lua_State* L) {
 	float x = luaL_checknumber(L, 1);
 	float y = luaL_checknumber(L, 2);
 
-	auto* v = (LuaVector2*)lua_newuserdata(L, sizeof(LuaVector2));
+	auto* v = (LuaVector2*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaVector2), LUA_TAG_VECTOR2);
 	v->x = x;
 	v->y = y;
 
-	luaL_getmetatable(L, LUA_VECTOR2);
-	lua_setmetatable(L, -2);
 
 	return 1;
 }
@@ -133,8 +131,30 @@ static int l_Vector2_Min(lua_State* L) {
 	return PushVector2(L, fminf(a->x, b->x), fminf(a->y, b->y));
 }
 
+static int l_Vector2_namecall(lua_State* L) {
+	int atom = -1;
+	const char* name = lua_namecallatom(L, &atom);
+
+	switch (atom) {
+		case ATOM_Abs: return l_Vector2_Abs(L);
+		case ATOM_Ceil: return l_Vector2_Ceil(L);
+		case ATOM_Floor: return l_Vector2_Floor(L);
+		case ATOM_Sign: return l_Vector2_Sign(L);
+		case ATOM_Cross: return l_Vector2_Cross(L);
+		case ATOM_Angle: return l_Vector2_Angle(L);
+		case ATOM_Dot: return l_Vector2_Dot(L);
+		case ATOM_FuzzyEq: return l_Vector2_FuzzyEq(L);
+		case ATOM_Lerp: return l_Vector2_Lerp(L);
+		case ATOM_Max: return l_Vector2_Max(L);
+		case ATOM_Min: return l_Vector2_Min(L);
+	}
+
+	luaL_error(L, "%s is not a valid method of Vector2", name ? name : "?");
+	return 0;
+}
+
 static int l_Vector2_index(lua_State* L) {
-	auto* v = (LuaVector2*)luaL_checkudata(L, 1, LUA_VECTOR2);
+	auto* v = CheckVector2(L, 1);
 	const char* key = luaL_checkstring(L, 2);
 
 	if (!strcmp(key, "Abs"))     { lua_pushcfunction(L, l_Vector2_Abs, "Abs"); return 1; }
@@ -162,7 +182,7 @@ static int l_Vector2_index(lua_State* L) {
 		float mag = sqrtf(v->x*v->x + v->y*v->y);
 
 		// Create new Vector2 userdata
-		auto* u = (LuaVector2*)lua_newuserdata(L, sizeof(LuaVector2));
+		auto* u = (LuaVector2*)lua_newuserdatataggedwithmetatable(L, sizeof(LuaVector2), LUA_TAG_VECTOR2);
 
 		if (mag > 0.0f) {
 	        u->x = v->x / mag;
@@ -172,8 +192,6 @@ static int l_Vector2_index(lua_State* L) {
 	        u->y = 0.0f;
 		}
 
-		luaL_getmetatable(L, LUA_VECTOR2);
-		lua_setmetatable(L, -2);
 
 		return 1;
 	}
@@ -188,15 +206,15 @@ static int l_Vector2_newindex(lua_State* L) {
 }
 
 static int l_Vector2_eq(lua_State* L) {
-	auto* a = (LuaVector2*)luaL_checkudata(L, 1, LUA_VECTOR2);
-	auto* b = (LuaVector2*)luaL_checkudata(L, 2, LUA_VECTOR2);
+	auto* a = CheckVector2(L, 1);
+	auto* b = CheckVector2(L, 2);
 
 	lua_pushboolean(L, a->x == b->x && a->y == b->y);
 	return 1;
 }
 
 static int l_Vector2_tostring(lua_State* L) {
-	auto* v = (LuaVector2*)luaL_checkudata(L, 1, LUA_VECTOR2);
+	auto* v = CheckVector2(L, 1);
 	lua_pushfstring(L, "Vector2(%f, %f)", v->x, v->y);
 	return 1;
 }
@@ -253,6 +271,7 @@ inline void RegisterVector2(lua_State* L) {
 	luaL_newmetatable(L, "LuaVector2");
 		lua_pushcfunction(L, l_Vector2_index, "index"); lua_setfield(L, -2, "__index");
 		lua_pushcfunction(L, l_Vector2_newindex, "newindex"); lua_setfield(L, -2, "__newindex");
+		lua_pushcfunction(L, l_Vector2_namecall, "namecall"); lua_setfield(L, -2, "__namecall");
 		lua_pushcfunction(L, l_Vector2_eq, "eq"); lua_setfield(L, -2, "__eq");
 		lua_pushcfunction(L, l_Vector2_tostring, "tostring"); lua_setfield(L, -2, "__tostring");
 		lua_pushcfunction(L, l_Vector2_add, "add"); lua_setfield(L, -2, "__add");
@@ -260,7 +279,7 @@ inline void RegisterVector2(lua_State* L) {
 		lua_pushcfunction(L, l_Vector2_mul, "mul"); lua_setfield(L, -2, "__mul");
 		lua_pushcfunction(L, l_Vector2_div, "div"); lua_setfield(L, -2, "__div");
 		lua_pushcfunction(L, l_Vector2_unm, "unm"); lua_setfield(L, -2, "__unm");
-	lua_pop(L, 1);
+	lua_setuserdatametatable(L, LUA_TAG_VECTOR2);
 
 	lua_newtable(L);
 		lua_pushcfunction(L, l_Vector2_newindex, "newindex"); lua_setfield(L, -2, "__newindex");
@@ -9,27 +9,25 @@
 #include "luacode.h"
 
 #include "utils/ExtraMath.h"
+#include "utils/LuaAtoms.h"
 
-#define LUA_VECTOR3 "LuaVector3"
+// Vector3 values are Luau's native vector type, they live inside the stack slot like numbers
+// so arithmetic on them (+ - * / and unary -) runs in the VM and never allocates
 
 struct LuaVector3 {
     float x, y, z;
 };
 
-static LuaVector3* CheckVector3(lua_State* L, int idx) {
-    return (LuaVector3*)luaL_checkudata(L, idx, LUA_VECTOR3);
+static const LuaVector3* CheckVector3(lua_State* L, int idx) {
+	const float* v = lua_tovector(L, idx);
+	if (!v)
+		luaL_typeerror(L, idx, "Vector3");
+
+	return reinterpret_cast<const LuaVector3*>(v);
 }
 
 static int PushVector3(lua_State* L, float x, float y, float z) {
-	auto* v = (LuaVector3*)lua_newuserdata(L, sizeof(LuaVector3));
-	
-	v->x = x;
-	v->y = y;
-	v->z = z;
-
-	luaL_getmetatable(L, LUA_VECTOR3);
-	lua_setmetatable(L, -2);
-	
+	lua_pushvector(L, x, y, z);
 	return 1;
 }
 
@@ -42,15 +40,7 @@ static int l_Vector3_new(lua_State* L) {
 	float y = luaL_checknumber(L, 2);
 	float z = luaL_checknumber(L, 3);
 
-	auto* v = (LuaVector3*)lua_newuserdata(L, sizeof(LuaVector3));
-	v->x = x;
-	v->y = y;
-	v->z = z;
-
-	luaL_getmetatable(L, LUA_VECTOR3);
-	lua_setmetatable(L, -2);
-
-	return 1;
+	return PushVector3(L, x, y, z);
 }
 
 static int l_Vector3_Abs(lua_State* L) {
@@ -142,8 +132,30 @@ static int l_Vector3_Min(lua_State* L) {
 }
 
 
+static int l_Vector3_namecall(lua_State* L) {
+	int atom = -1;
+	const char* name = lua_namecallatom(L, &atom);
+
+	switch (atom) {
+		case ATOM_Abs: return l_Vector3_Abs(L);
+		case ATOM_Ceil: return l_Vector3_Ceil(L);
+		case ATOM_Floor: return l_Vector3_Floor(L);
+		case ATOM_Sign: return l_Vector3_Sign(L);
+		case ATOM_Cross: return l_Vector3_Cross(L);
+		case ATOM_Angle: return l_Vector3_Angle(L);
+		case ATOM_Dot: return l_Vector3_Dot(L);
+		case ATOM_FuzzyEq: return l_Vector3_FuzzyEq(L);
+		case ATOM_Lerp: return l_Vector3_Lerp(L);
+		case ATOM_Max: return l_Vector3_Max(L);
+		case ATOM_Min: return l_Vector3_Min(L);
+	}
+
+	luaL_error(L, "%s is not a valid method of Vector3", name ? name : "?");
+	return 0;
+}
+
 static int l_Vector3_index(lua_State* L) {
-	auto* v = (LuaVector3*)luaL_checkudata(L, 1, LUA_VECTOR3);
+	auto* v = CheckVector3(L, 1);
 	const char* key = luaL_checkstring(L, 2);
 
 	if (!strcmp(key, "Abs"))     { lua_pushcfunction(L, l_Vector3_Abs, "Abs"); return 1; }
@@ -171,23 +183,10 @@ static int l_Vector3_index(lua_State* L) {
 	if (std::strcmp(key, "Unit") == 0) {
 		float mag = sqrtf(v->x*v->x + v->y*v->y + v->z*v->z);
 
-		// Create new Vector3 userdata
-		auto* u = (LuaVector3*)lua_newuserdata(L, sizeof(LuaVector3));
-
-		if (mag > 0.0f) {
-			u->x = v->x / mag;
-			u->y = v->y / mag;
-			u->z = v->z / mag;
-		} else {
-			u->x = 0.0f;
-			u->y = 0.0f;
-			u->z = 0.0f;
-		}
+		if (mag > 0.0f)
+			return PushVector3(L, v->x / mag, v->y / mag, v->z / mag);
 
-		luaL_getmetatable(L, LUA_VECTOR3);
-		lua_setmetatable(L, -2);
-
-		return 1;
+		return PushVector3(L, 0.0f, 0.0f, 0.0f);
 	}
 
 	lua_pushnil(L);
@@ -199,77 +198,21 @@ static int l_Vector3_newindex(lua_State* L) {
 	return 0;
 }
 
-static int l_Vector3_eq(lua_State* L) {
-	auto* a = (LuaVector3*)luaL_checkudata(L, 1, LUA_VECTOR3);
-	auto* b = (LuaVector3*)luaL_checkudata(L, 2, LUA_VECTOR3);
-
-	lua_pushboolean(L, a->x == b->x && a->y == b->y && a->z == b->z);
-	return 1;
-}
-
 static int l_Vector3_tostring(lua_State* L) {
-	auto* v = (LuaVector3*)luaL_checkudata(L, 1, LUA_VECTOR3);
+	auto* v = CheckVector3(L, 1);
 	lua_pushfstring(L, "Vector3(%f, %f, %f)", v->x, v->y, v->z);
 	return 1;
 }
 
-static int l_Vector3_add(lua_State* L) {
-	auto* a = CheckVector3(L, 1);
-	auto* b = CheckVector3(L, 2);
-	return PushVector3(L, a->x + b->x, a->y + b->y, a->z + b->z);
-}
-
-static int l_Vector3_sub(lua_State* L) {
-	auto* a = CheckVector3(L, 1);
-	auto* b = CheckVector3(L, 2);
-	return PushVector3(L, a->x - b->x, a->y - b->y, a->z - b->z);
-}
-
-static int l_Vector3_mul(lua_State* L) {
-	if (lua_isnumber(L, 1)) {
-		float s = (float)lua_tonumber(L, 1);
-		auto* v = CheckVector3(L, 2);
-		return PushVector3(L, v->x*s, v->y*s, v->z*s);
-	}
-
-	if (lua_isnumber(L, 2)) {
-		auto* v = CheckVector3(L, 1);
-		float s = (float)lua_tonumber(L, 2);
-		return PushVector3(L, v->x*s, v->y*s, v->z*s);
-	}
-
-	luaL_error(L, "Vector3 * Vector3 is not supported");
-	return 0; 
-}
-
-static int l_Vector3_div(lua_State* L) {
-	auto* v = CheckVector3(L, 1);
-	float s = (float)luaL_checknumber(L, 2);
-
-	if (s == 0.0f) {
-		luaL_error(L, "Cannot divide Vector3 by zero");
-		return 0;
-	}
-
-	return PushVector3(L, v->x / s, v->y / s, v->z / s);
-}
-
-static int l_Vector3_unm(lua_State* L) {
-	auto* v = CheckVector3(L, 1);
-	return PushVector3(L, -v->x, -v->y, -v->z);
-}
-
 inline void RegisterVector3(lua_State* L) {
-	luaL_newmetatable(L, "LuaVector3");
+	// vectors share one metatable for the whole VM, set through any vector value
+	lua_pushvector(L, 0, 0, 0);
+	lua_newtable(L);
 		lua_pushcfunction(L, l_Vector3_index, "Vector3.__index"); lua_setfield(L, -2, "__index");
 		lua_pushcfunction(L, l_Vector3_newindex, "Vector3.__newindex"); lua_setfield(L, -2, "__newindex");
-		lua_pushcfunction(L, l_Vector3_eq, "Vector3.__eq"); lua_setfield(L, -2, "__eq");
+		lua_pushcfunction(L, l_Vector3_namecall, "Vector3.__namecall"); lua_setfield(L, -2, "__namecall");
 		lua_pushcfunction(L, l_Vector3_tostring, "Vector3.__tostring"); lua_setfield(L, -2, "__tostring");
-		lua_pushcfunction(L, l_Vector3_add, "Vector3.__add"); lua_setfield(L, -2, "__add");
-		lua_pushcfunction(L, l_Vector3_sub, "Vector3.__sub"); lua_setfield(L, -2, "__sub");
-		lua_pushcfunction(L, l_Vector3_mul, "Vector3.__mul"); lua_setfield(L, -2, "__mul");
-		lua_pushcfunction(L, l_Vector3_div, "Vector3.__div"); lua_setfield(L, -2, "__div");
-		lua_pushcfunction(L, l_Vector3_unm, "Vector3.__unm"); lua_setfield(L, -2, "__unm");
+	lua_setmetatable(L, -2);
 	lua_pop(L, 1);
 
 	lua_newtable(L);
@@ -18,6 +18,8 @@
 #include "raymath.h"
 
 #include "core/LuaScheduler.h"
+#include "core/BytecodeCache.h"
+#include "core/RuntimeClock.h"
 
 #include "datatypes/LuaSignal.h"
 
@@ -47,23 +49,21 @@ Debris* gDebris = nullptr;
 BaseScript* gMainScript = nullptr;
 
 LuaScheduler gLuaScheduler;
+InstanceCache gInstanceCache;
+SlotMap<Instance> gInstances;
+SlotMap<ObjectSound> gSounds;
+RuntimeClock gRuntimeClock;
+BytecodeCache gBytecodeCache;
 
 #include "core/ScriptingAPI.h"
 #include "core/Rendering.h"
 
 #include "utils/rayutils.h"
 
-void UpdateDescendantSoundStreams(Instance* inst) {
-	if (std::strcmp(inst->ClassName(), "Sound") == 0) {
-		ObjectSound* sound = (ObjectSound*)inst;
+void UpdateSoundStreams() {
+	gSounds.ForEach([](ObjectSound* sound) {
 		sound->Update();
-	}
-
-	if (inst->Children.size() > 0) {
-		for (Instance* child : inst->Children) {
-			UpdateDescendantSoundStreams(child);
-		}
-	}
+	});
 }
 
 struct LuauScriptData {
@@ -168,7 +168,9 @@ static int RunLoaderMenu() {
 
 void SetupGame() {
 	gLuaScheduler.L = luaL_newstate();
+	lua_callbacks(gLuaScheduler.L)->useratom = LuaUserAtom;
 	luaL_openlibs(gLuaScheduler.L);
+	EnableNativeCodegen(gLuaScheduler);
 
 	#define QuickCreateService(v, t) v = new t{}; v->SetParent(gGame)
 
@@ -189,11 +191,122 @@ void SetupGame() {
 
 void ShutdownGame() {
 	gGame->Destroy();
+	FreeDestroyedInstances();
 
 	lua_close(gLuaScheduler.L);
 }
 
-int main() {
+void AddMainScript(const std::string& source) {
+	gMainScript = new BaseScript{}; gMainScript->SetParent(gWorkspace);
+	gMainScript->Name = "Script";
+	gMainScript->Source = source;
+}
+
+// the main script is one of these, it lives in workspace
+void RunScripts() {
+	StartScripts(gLuaScheduler, {gWorkspace, gServerScriptService});
+}
+
+// one simulation tick, shared by the windowed loop and headless runs
+void StepGame(double deltaTime) {
+	FireSignal(gRunService->Stepped, [&](lua_State* L) {
+		lua_pushnumber(L, GetRuntimeTime());
+		lua_pushnumber(L, deltaTime);
+	});
+
+	gLuaScheduler.Step();
+	gDebris->UpdateDebris();
+
+	FireSignal(gRunService->Heartbeat, [&](lua_State* L) {
+		lua_pushnumber(L, deltaTime);
+	});
+
+	FreeDestroyedInstances();
+	CollectInstances();
+}
+
+struct LaunchOptions {
+	bool headless = false;
+	std::string scriptPath;
+	int frames = -1; // -1 runs until every thread has finished
+	double tickRate = 60.0;
+	bool bytecodeCache = true; // writes compiled scripts to .blockadia/cache in the working directory
+};
+
+static bool ParseLaunchOptions(int argc, char** argv, LaunchOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+			options.headless = true;
+			options.scriptPath = argv[++i];
+		} else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			options.frames = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--tickrate") == 0 && i + 1 < argc) {
+			options.tickRate = std::atof(argv[++i]);
+		} else if (std::strcmp(argv[i], "--no-bytecode-cache") == 0) {
+			options.bytecodeCache = false;
+		} else {
+			printf("usage: Blockadia [--headless <file.luau> [--frames N] [--tickrate HZ]] [--no-bytecode-cache]\n");
+			return false;
+		}
+	}
+
+	if (options.tickRate <= 0.0) {
+		printf("HEADLESS: tick rate has to be positive\n");
+		return false;
+	}
+
+	return true;
+}
+
+// no window, audio or renderer, the script runs on a fixed tick until
+// it reaches the frame limit or has no threads left
+static int RunHeadless(const LaunchOptions& options) {
+	SetTraceLogLevel(LOG_WARNING);
+
+	char* source = LoadFileText(options.scriptPath.c_str());
+	if (!source) {
+		printf("HEADLESS: Failed to read script '%s'\n", options.scriptPath.c_str());
+		return 1;
+	}
+
+	gRuntimeClock.fixedStep = true;
+	gRuntimeClock.time = 0.0;
+
+	SetupGame();
+	AddMainScript(source);
+	UnloadFileText(source);
+
+	RunScripts();
+
+	double deltaTime = 1.0 / options.tickRate;
+	int frame = 0;
+
+	while (options.frames < 0 || frame < options.frames) {
+		if (!gLuaScheduler.HasThreads()) break;
+
+		StepGame(deltaTime);
+		gDebugVisualService->Clear();
+
+		gRuntimeClock.time += deltaTime;
+		frame++;
+	}
+
+	printf("HEADLESS: Ran %d frames (%.3fs simulated)\n", frame, gRuntimeClock.time);
+
+	ShutdownGame();
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	LaunchOptions options;
+	if (!ParseLaunchOptions(argc, argv, options))
+		return 1;
+
+	gBytecodeCache.useDisk = options.bytecodeCache;
+
+	if (options.headless)
+		return RunHeadless(options);
+
 	SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 	InitWindow(1600, 900, "Blockadia");
 	SetTargetFPS(60);
@@ -228,16 +341,11 @@ int main() {
 
 	if (choice != -1 && choice < luauScripts.size()) {
 		LuauScriptData scriptData = luauScripts[choice];
-
-		gMainScript = new BaseScript{}; gMainScript->SetParent(gWorkspace);
-		gMainScript->Name = "Script";
-
-		std::string luauScript = scriptData.content.data();
-		gMainScript->Source = luauScript;
-
-		StartScript(gLuaScheduler, gMainScript);
+		AddMainScript(scriptData.content);
 	}
 
+	RunScripts();
+
 	ReadyRenderer();
 	while(!WindowShouldClose()) {
 		float frameTime = GetFrameTime();
@@ -245,8 +353,8 @@ int main() {
 		BeginDrawing();
 		ClearBackground(BLUE);
 		
-		gLuaScheduler.Step();
-		UpdateDescendantSoundStreams(gGame);
+		StepGame(frameTime);
+		UpdateSoundStreams();
 		camController.StepCamera();
 		BeginMode3D(camera);
 
@@ -254,7 +362,7 @@ int main() {
 			lua_pushnumber(L, frameTime);
 		});
 
-		RenderWorkspace();
+		RenderWorkspace(camera);
 		RenderDebugVisuals3D(gDebugVisualService);
 
 		EndMode3D();
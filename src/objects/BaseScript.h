@@ -9,25 +9,40 @@ struct BaseScript : Instance {
 	std::string Name = "BaseScript";
 	std::string Source = "print('Hello World')";
 
+	// only read when scripts are started, changing it afterwards doesn't stop or start anything
+	bool Enabled = true;
+
 	const char* ClassName() const override {
 		return "BaseScript";
 	}
 
-	bool LuaGet(lua_State* L, const char* key) override {
-		if (std::strcmp(key, "Source") == 0) {
-			lua_pushstring(L, Source.c_str());
-			return true;
-		}
-
-		return Instance::LuaGet(L, key);
+	static const LuaPropertyTable& ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_Source,
+				[](lua_State* L, Instance* obj) {
+					BaseScript* self = static_cast<BaseScript*>(obj);
+					lua_pushstring(L, self->Source.c_str());
+				},
+				[](lua_State* L, Instance* obj, int idx) {
+					BaseScript* self = static_cast<BaseScript*>(obj);
+					self->Source = luaL_checkstring(L, idx);
+				}},
+			{ATOM_Enabled,
+				[](lua_State* L, Instance* obj) {
+					BaseScript* self = static_cast<BaseScript*>(obj);
+					lua_pushboolean(L, self->Enabled);
+				},
+				[](lua_State* L, Instance* obj, int idx) {
+					BaseScript* self = static_cast<BaseScript*>(obj);
+					self->Enabled = luaL_checkboolean(L, idx);
+				}},
+		};
+
+		static const LuaPropertyTable table(&Instance::ClassProperties(), own);
+		return table;
 	}
 
-	bool LuaSet(lua_State* L, const char* key, int idx) override {
-		if (std::strcmp(key, "Source") == 0) {
-			Source = luaL_checkstring(L, idx);
-			return true;
-		}
-
-		return Instance::LuaSet(L, key, idx);
+	const LuaPropertyTable& Properties() const override {
+		return ClassProperties();
 	}
 };
\ No newline at end of file
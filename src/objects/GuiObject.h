@@ -38,85 +38,81 @@ struct GuiObject : Instance {
 		Position = {{0, 0}, {0, 0}};
 	}
 
-	bool LuaGet(lua_State *L, const char *key) override {
-		if (!strcmp(key, "Size")) {
-			PushUDim2(L, Size.x, Size.y);
-			return true;
-		}
-
-		if (!strcmp(key, "Position")) {
-			PushUDim2(L, Position.x, Position.y);
-			return true;
-		}
-
-		if (!strcmp(key, "AnchorPoint")) {
-			PushVector2(L, AnchorPoint.x, AnchorPoint.y);
-			return true;
-		}
-
-		if (!strcmp(key, "BackgroundColor3")) {
-			PushColor3(L, BackgroundColor.x, BackgroundColor.y, BackgroundColor.z);
-			return true;
-		}
-
-		if (!strcmp(key, "BackgroundTransparency")) {
-			lua_pushnumber(L, BackgroundTransparency);
-			return true;
-		}
-
-		if (!strcmp(key, "Rotation")) {
-			lua_pushnumber(L, Rotation);
-			return true;
-		}
-
-		if (!strcmp(key, "Visible")) {
-			lua_pushboolean(L, Visible);
-			return true;
-		}
-
-		return Instance::LuaGet(L, key);
+	static const LuaPropertyTable &ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_Size,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					PushUDim2(L, self->Size.x, self->Size.y);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					self->Size = *CheckUDim2(L, idx);
+				}},
+			{ATOM_Position,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					PushUDim2(L, self->Position.x, self->Position.y);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					self->Position = *CheckUDim2(L, idx);
+				}},
+			{ATOM_AnchorPoint,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					PushVector2(L, self->AnchorPoint.x, self->AnchorPoint.y);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					auto *v = CheckVector2(L, idx);
+					self->AnchorPoint = {v->x, v->y};
+				}},
+			{ATOM_BackgroundColor3,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					PushColor3(L, self->BackgroundColor.x, self->BackgroundColor.y, self->BackgroundColor.z);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					LuaColor3 *clr = CheckColor3(L, idx);
+					self->BackgroundColor = {clr->r, clr->g, clr->b};
+				}},
+			{ATOM_BackgroundTransparency,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					lua_pushnumber(L, self->BackgroundTransparency);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					self->BackgroundTransparency = std::clamp((float)luaL_checknumber(L, idx), 0.0f, 1.0f);
+				}},
+			{ATOM_Rotation,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					lua_pushnumber(L, self->Rotation);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					self->Rotation = luaL_checknumber(L, idx);
+				}},
+			{ATOM_Visible,
+				[](lua_State *L, Instance *obj) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					lua_pushboolean(L, self->Visible);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					GuiObject *self = static_cast<GuiObject *>(obj);
+					self->Visible = lua_toboolean(L, idx);
+				}},
+		};
+
+		static const LuaPropertyTable table(&Instance::ClassProperties(), own);
+		return table;
 	}
 
-	bool LuaSet(lua_State *L, const char *key, int idx) override {
-		if (!strcmp(key, "Size")) {
-			Size = *CheckUDim2(L, idx);
-			return true;
-		}
-
-		if (!strcmp(key, "Position")) {
-			Position = *CheckUDim2(L, idx);
-			return true;
-		}
-
-		if (!strcmp(key, "AnchorPoint")) {
-			auto *v = CheckVector2(L, idx);
-			AnchorPoint = {v->x, v->y};
-			return true;
-		}
-
-		if (!strcmp(key, "BackgroundColor3")) {
-			LuaColor3 *clr = CheckColor3(L, idx);
-			BackgroundColor = {clr->r, clr->g, clr->b};
-
-			return true;
-		}
-
-		if (!strcmp(key, "BackgroundTransparency")) {
-			BackgroundTransparency = std::clamp((float)luaL_checknumber(L, idx), 0.0f, 1.0f);
-			return true;
-		}
-
-		if (!strcmp(key, "Rotation")) {
-			Rotation = luaL_checknumber(L, idx);
-			return true;
-		}
-
-		if (!strcmp(key, "Visible")) {
-			Visible = lua_toboolean(L, idx);
-			return true;
-		}
-
-		return Instance::LuaSet(L, key, idx);
+	const LuaPropertyTable &Properties() const override {
+		return ClassProperties();
 	}
 
 	virtual void Draw(Rectangle rect, Color color) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <cstring>
 #include <vector>
@@ -9,28 +10,126 @@
 #include "lualib.h"
 #include "luacode.h"
 
+#include "utils/LuaAtoms.h"
+#include "utils/LuaTags.h"
+#include "utils/SlotMap.h"
+
 
 struct Instance;
+
+// every live Instance has a slot here, Lua userdata and native services keep the handle
+// instead of the pointer so a freed Instance resolves to nullptr
+extern SlotMap<Instance> gInstances;
+
+// each Instance has at most one userdata, kept in a weak valued registry table keyed by
+// the Instance pointer, so == and table keys work and pushing it again doesn't allocate
+struct InstanceCache {
+	lua_State* L = nullptr;
+	int ref = LUA_NOREF;
+
+	// Instances whose userdata the GC collected, looked at by CollectInstances
+	// handles since an entry can be freed by FreeDestroyedInstances before it's looked at
+	std::vector<SlotHandle> collected;
+
+	// roots of destroyed subtrees, freed together by FreeDestroyedInstances
+	std::vector<Instance*> destroyed;
+};
+
+extern InstanceCache gInstanceCache;
+
 static Instance* CheckInstance(lua_State* L, int index) {
-	return *(Instance**)luaL_checkudata(L, index, "Instance");
+	SlotHandle* handle = static_cast<SlotHandle*>(CheckUserdataTagged(L, index, LUA_TAG_INSTANCE, "Instance"));
+
+	Instance* inst = gInstances.Get(*handle);
+	if (!inst)
+		luaL_error(L, "attempt to use an Instance that has been destroyed");
+
+	return inst;
 }
 
-static void PushInstance(lua_State* L, Instance* inst) {
-	Instance** udata = (Instance**)lua_newuserdata(L, sizeof(Instance*));
-	*udata = inst;
+static void PushInstance(lua_State* L, Instance* inst);
+static void InstanceDestructor(lua_State* L, void* data);
+
+// drops the cache entry and clears the handle in the userdata so scripts still holding it
+// get an error right away instead of once the Instance is freed
+static void ForgetInstance(Instance* inst) {
+	lua_State* L = gInstanceCache.L;
+	if (!L) return;
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, gInstanceCache.ref);
+	lua_pushlightuserdata(L, inst);
+	lua_rawget(L, -2);
+
+	if (SlotHandle* handle = (SlotHandle*)lua_touserdatatagged(L, -1, LUA_TAG_INSTANCE))
+		*handle = {};
+
+	lua_pop(L, 1);
+
+	lua_pushlightuserdata(L, inst);
+	lua_pushnil(L);
+	lua_rawset(L, -3);
 
-	luaL_getmetatable(L, "Instance");
-	lua_setmetatable(L, -2);
+	lua_pop(L, 1);
 }
 
+// one property of a class, get pushes the value and set reads it from valueIndex
+// set is left null for read only properties
+struct LuaProperty {
+	int16_t atom;
+	void (*get)(lua_State* L, Instance* self);
+	void (*set)(lua_State* L, Instance* self, int valueIndex);
+};
+
+// a class's properties indexed by atom, built once from its base class table and its own
+// entries so a lookup costs the same no matter how deep the class is
+struct LuaPropertyTable {
+	LuaProperty entries[ATOM_COUNT] = {};
+
+	template<size_t N>
+	LuaPropertyTable(const LuaPropertyTable* base, const LuaProperty (&own)[N]) {
+		if (base)
+			*this = *base;
+
+		for (const LuaProperty& prop : own)
+			entries[prop.atom] = prop;
+	}
+
+	const LuaProperty* Find(int atom) const {
+		if (atom < 0 || atom >= ATOM_COUNT) return nullptr;
+		return &entries[atom];
+	}
+};
+
 struct Instance {
 	std::string Name = "Instance";
 	Instance* Parent = nullptr;
 	std::vector<Instance*> Children;
 
 	bool ParentingLocked = false;
+	bool Destroyed = false;
+
+	// an Instance that is parentless and has no userdata anywhere in its subtree is
+	// unreachable and gets freed
+	// a count and not a flag, the GC drops a dead userdata from the cache before sweeping it
+	// so a new one can be pushed for the same Instance while the old one is still pending
+	int LuaUserdataCount = 0;
+
+	SlotHandle Handle;
+
+	Instance() {
+		Handle = gInstances.Insert(this);
+	}
+
+	// clones start detached and get their own slot, only the Name and lock are copied
+	Instance(const Instance& other) : Name(other.Name), ParentingLocked(other.ParentingLocked) {
+		Handle = gInstances.Insert(this);
+	}
 
-	virtual ~Instance() = default;
+	Instance& operator=(const Instance&) = delete;
+
+	virtual ~Instance() {
+		gInstances.Erase(Handle);
+	}
 
 	virtual const char* ClassName() const {
 		return "Instance";
@@ -141,6 +240,39 @@ struct Instance {
 		return 1;
 	}
 
+	static const LuaPropertyTable& ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_Name,
+				[](lua_State* L, Instance* self) { lua_pushstring(L, self->Name.c_str()); },
+				[](lua_State* L, Instance* self, int idx) { self->Name = luaL_checkstring(L, idx); }},
+			{ATOM_Parent,
+				[](lua_State* L, Instance* self) {
+					if (self->Parent)
+						PushInstance(L, self->Parent);
+					else
+						lua_pushnil(L);
+				},
+				[](lua_State* L, Instance* self, int idx) {
+					if (self->ParentingLocked)
+						luaL_error(L, "attempted to set parent of object whose parent is locked");
+
+					self->SetParent(CheckInstance(L, idx));
+				}},
+			{ATOM_ClassName,
+				[](lua_State* L, Instance* self) { lua_pushstring(L, self->ClassName()); },
+				nullptr},
+		};
+
+		static const LuaPropertyTable table(nullptr, own);
+		return table;
+	}
+
+	// every class with properties overrides this to return its own ClassProperties
+	virtual const LuaPropertyTable& Properties() const {
+		return ClassProperties();
+	}
+
+	// anything that isn't in the property table, like children and methods read with '.'
 	virtual bool LuaGet(lua_State* L, const char* key) {
 
 		// methods
@@ -164,25 +296,6 @@ struct Instance {
 			return true;
 		}
 
-		// properties
-		if (std::strcmp(key, "Name") == 0) {
-			lua_pushstring(L, Name.c_str());
-			return true;
-		}
-
-		if (std::strcmp(key, "Parent") == 0){
-			if (Parent)
-				PushInstance(L, Parent);
-			else
-				lua_pushnil(L);
-			return true;
-		}
-
-		if (std::strcmp(key, "ClassName") == 0) {
-			lua_pushstring(L, ClassName());
-			return true;
-		}
-
 		// getting instance
 		Instance* childInstance = FindFirstChild(key);
 		if (childInstance) {
@@ -193,32 +306,42 @@ struct Instance {
 		return false;
 	}
 
-	virtual bool LuaSet(lua_State* L, const char* key, int valueIndex) {
-		if (strcmp(key, "Name") == 0) {
-			Name = luaL_checkstring(L, valueIndex);
-			return true;
+	// methods called with ':' go through __namecall and land here instead of LuaGet
+	virtual lua_CFunction LuaMethod(int atom) {
+		switch (atom) {
+			case ATOM_Clone: return l_Clone;
+			case ATOM_GetChildren: return l_GetChildren;
+			case ATOM_GetDescendants: return l_GetDescendants;
+			case ATOM_Destroy: return l_Destroy;
 		}
 
-		if (strcmp(key, "Parent") == 0) {
-			if (ParentingLocked) {
-				luaL_error(L, "attempted to set parent of object whose parent is locked");
-				return false;
-			} else {
-				Instance* newParent = CheckInstance(L, valueIndex);
-				SetParent(newParent);
-			}
-
-			return true;
-		}
+		return nullptr;
+	}
 
+	virtual bool LuaSet(lua_State* L, const char* key, int valueIndex) {
 		return false;
 	}
 
+	// called on every ancestor when an instance (and its subtree) enters or leaves the subtree
+	virtual void DescendantAdded(Instance* descendant) {}
+	virtual void DescendantRemoving(Instance* descendant) {}
+
+	// called on every ancestor after a descendant changed a property they may be tracking
+	virtual void DescendantChanged(Instance* descendant) {}
+
+	void NotifyAncestorsChanged() {
+		for (Instance* ancestor = Parent; ancestor; ancestor = ancestor->Parent)
+			ancestor->DescendantChanged(this);
+	}
+
 	void SetParent(Instance* newParent) {
 		if (newParent == Parent) return;
 
 		// Remove from old parent
 		if (Parent) {
+			for (Instance* ancestor = Parent; ancestor; ancestor = ancestor->Parent)
+				ancestor->DescendantRemoving(this);
+
 			auto& siblings = Parent->Children;
 			siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
 		}
@@ -226,13 +349,32 @@ struct Instance {
 		Parent = newParent;
 
 		// Add to new parent
-		if (Parent)
+		if (Parent) {
 			Parent->Children.push_back(this);
+
+			for (Instance* ancestor = Parent; ancestor; ancestor = ancestor->Parent)
+				ancestor->DescendantAdded(this);
+		}
+	}
+
+	void MarkDestroyed() {
+		Destroyed = true;
+		ParentingLocked = true;
+		ForgetInstance(this);
+
+		for (Instance* child : Children)
+			child->MarkDestroyed();
 	}
 
+	// the subtree is detached and marked right away but stays allocated until the end of
+	// the frame, so anything still pointing into it this frame can check Destroyed
 	virtual void Destroy() {
+		if (Destroyed) return;
+
 		SetParent(nullptr);
-		delete this;
+		MarkDestroyed();
+
+		gInstanceCache.destroyed.push_back(this);
 	}
 
 	static int l_Destroy(lua_State* L) {
@@ -246,7 +388,17 @@ struct Instance {
 
 	static int Index(lua_State* L) {
 		Instance* obj = CheckInstance(L, 1);
-		const char* key = luaL_checkstring(L, 2);
+
+		int atom = -1;
+		const char* key = lua_tostringatom(L, 2, &atom);
+		if (!key)
+			key = luaL_checkstring(L, 2);
+
+		const LuaProperty* prop = obj->Properties().Find(atom);
+		if (prop && prop->get) {
+			prop->get(L, obj);
+			return 1;
+		}
 
 		if (obj->LuaGet(L, key))
 			return 1;
@@ -255,9 +407,34 @@ struct Instance {
 		return 1;
 	}
 
+	static int Namecall(lua_State* L) {
+		Instance* obj = CheckInstance(L, 1);
+
+		int atom = -1;
+		const char* name = lua_namecallatom(L, &atom);
+
+		lua_CFunction method = obj->LuaMethod(atom);
+		if (!method) {
+			luaL_error(L, "%s is not a valid method of %s", name ? name : "?", obj->ClassName());
+			return 0;
+		}
+
+		return method(L);
+	}
+
 	static int NewIndex(lua_State* L) {
 		Instance* obj = CheckInstance(L, 1);
-		const char* key = luaL_checkstring(L, 2);
+
+		int atom = -1;
+		const char* key = lua_tostringatom(L, 2, &atom);
+		if (!key)
+			key = luaL_checkstring(L, 2);
+
+		const LuaProperty* prop = obj->Properties().Find(atom);
+		if (prop && prop->set) {
+			prop->set(L, obj, 3);
+			return 0;
+		}
 
 		if (!obj->LuaSet(L, key, 3))
 			luaL_error(L, "invalid type for property '%s'", key);
@@ -270,15 +447,122 @@ struct Instance {
 		
 		lua_pushcfunction(L, Index, "__index"); lua_setfield(L, -2, "__index");
 		lua_pushcfunction(L, NewIndex, "__newindex"); lua_setfield(L, -2, "__newindex");
+		lua_pushcfunction(L, Namecall, "__namecall"); lua_setfield(L, -2, "__namecall");
 		//lua_pushcfunction(L, m_ToString, "__tostring"); lua_setfield(L, -2, "__tostring");
 		//lua_pushcfunction(L, l_GetChildren, "GetChildren"); lua_setfield(L, -2, "GetChildren");
 		//lua_pushcfunction(L, l_FindFirstChild, "FindFirstChild"); lua_setfield(L, -2, "FindFirstChild");
 		//lua_pushcfunction(L, l_Destroy, "Destroy"); lua_setfield(L, -2, "Destroy");
 		
+		lua_setuserdatametatable(L, LUA_TAG_INSTANCE);
+		lua_setuserdatadtor(L, LUA_TAG_INSTANCE, InstanceDestructor);
+
+		lua_newtable(L);
+			lua_newtable(L);
+				lua_pushstring(L, "v"); lua_setfield(L, -2, "__mode");
+			lua_setmetatable(L, -2);
+		gInstanceCache.ref = lua_ref(L, -1);
+		gInstanceCache.L = lua_mainthread(L);
 		lua_pop(L, 1);
 	}
 };
 
+static void PushInstance(lua_State* L, Instance* inst) {
+	if (!inst) {
+		lua_pushnil(L);
+		return;
+	}
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, gInstanceCache.ref);
+	lua_pushlightuserdata(L, inst);
+	lua_rawget(L, -2);
+
+	if (!lua_isnil(L, -1)) {
+		lua_remove(L, -2);
+		return;
+	}
+
+	lua_pop(L, 1);
+
+	SlotHandle* handle = (SlotHandle*)lua_newuserdatataggedwithmetatable(L, sizeof(SlotHandle), LUA_TAG_INSTANCE);
+	*handle = inst->Handle;
+	inst->LuaUserdataCount++;
+
+	lua_pushlightuserdata(L, inst);
+	lua_pushvalue(L, -2);
+	lua_rawset(L, -4);
+
+	lua_remove(L, -2);
+}
+
+// the VM calls this when an Instance userdata is collected, freeing has to wait for
+// CollectInstances since the GC can't be reentered from here
+static void InstanceDestructor(lua_State* L, void* data) {
+	Instance* inst = gInstances.Get(*static_cast<SlotHandle*>(data));
+	if (!inst) return;
+
+	inst->LuaUserdataCount--;
+
+	// destroyed ones are freed by FreeDestroyedInstances either way
+	if (!inst->Destroyed)
+		gInstanceCache.collected.push_back(inst->Handle);
+}
+
+static bool IsSubtreeUnreferenced(Instance* inst) {
+	if (inst->LuaUserdataCount > 0)
+		return false;
+
+	for (Instance* child : inst->Children) {
+		if (!IsSubtreeUnreferenced(child))
+			return false;
+	}
+
+	return true;
+}
+
+static void DeleteSubtree(Instance* inst) {
+	for (Instance* child : inst->Children)
+		DeleteSubtree(child);
+
+	delete inst;
+}
+
+// frees destroyed subtrees, anything still holding a handle to them resolves it to nullptr
+static void FreeDestroyedInstances() {
+	for (Instance* root : gInstanceCache.destroyed)
+		DeleteSubtree(root);
+
+	gInstanceCache.destroyed.clear();
+}
+
+// frees every parentless tree nothing refers to anymore, run once per frame outside of Lua
+static void CollectInstances() {
+	auto& collected = gInstanceCache.collected;
+	if (collected.empty()) return;
+
+	// roots are found before anything is freed, entries can be inside each other's subtree
+	std::vector<Instance*> roots;
+
+	for (SlotHandle handle : collected) {
+		Instance* inst = gInstances.Get(handle);
+		if (!inst) continue;
+
+		Instance* root = inst;
+		while (root->Parent)
+			root = root->Parent;
+
+		if (root->ParentingLocked || std::find(roots.begin(), roots.end(), root) != roots.end())
+			continue;
+
+		if (IsSubtreeUnreferenced(root))
+			roots.push_back(root);
+	}
+
+	collected.clear();
+
+	for (Instance* root : roots)
+		DeleteSubtree(root);
+}
+
 template<typename Derived, typename Base = Instance>
 struct Cloneable : public Base {
 	Instance* CloneSelf() const override {
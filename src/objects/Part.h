@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <raylib.h>
+#include <raymath.h>
 #include <string>
 #include <vector>
 
@@ -13,6 +17,34 @@
 #include "datatypes/LuaVector3.h"
 #include "objects/Instance.h"
 
+enum PartShape {
+	PART_SHAPE_BLOCK = 0,
+	PART_SHAPE_BALL,
+	PART_SHAPE_CYLINDER,
+
+	PART_SHAPE_COUNT
+};
+
+static PartShape PartShapeFromString(const std::string& shape) {
+	if (shape == "Ball") return PART_SHAPE_BALL;
+	if (shape == "Cylinder") return PART_SHAPE_CYLINDER;
+
+	return PART_SHAPE_BLOCK;
+}
+
+enum PartMaterial {
+	PART_MATERIAL_SMOOTH_PLASTIC = 0,
+	PART_MATERIAL_PLASTIC,
+
+	PART_MATERIAL_COUNT
+};
+
+static PartMaterial PartMaterialFromString(const std::string& material) {
+	if (material == "Plastic") return PART_MATERIAL_PLASTIC;
+
+	return PART_MATERIAL_SMOOTH_PLASTIC;
+}
+
 struct Part : Instance {
 	Vector3 Position{0, 0.5, 0};
 	Vector3 Rotation{0, 0, 0};
@@ -23,103 +55,314 @@ struct Part : Instance {
 	// its baked into the color property since its a raylib color
 
 	std::string Shape = "Block";
+	PartShape ShapeType = PART_SHAPE_BLOCK; // parsed from Shape so the renderer never compares strings
+
+	// "Plastic" is drawn with the stud texture, "SmoothPlastic" is plain
+	std::string Material = "SmoothPlastic";
+	PartMaterial MaterialType = PART_MATERIAL_SMOOTH_PLASTIC;
 	bool Anchored = false;
 
+	// world matrix built from Size, Rotation and Position, plus the world AABB around it
+	// only rebuilt after one of those is set, most parts never move
+	Matrix transform;
+	BoundingBox bounds;
+	bool transformDirty = true;
+
+	// slot in Workspace::RenderParts, or in its static chunk while inStaticChunk is set
+	// -1 while outside of the workspace
+	int renderIndex = -1;
+	bool inStaticChunk = false;
+	uint64_t chunkKey = 0;
+
+	// leaf in Workspace::PartTree, -1 while outside of the workspace
+	int treeProxy = -1;
+
+	// lod the renderer picked last frame, kept so it only switches past a margin
+	int lodLevel = 0;
+
 	const char* ClassName() const override {
 		return "Part";
 	}
 
-	bool LuaGet(lua_State *L, const char *key) override {
-		if (std::strcmp(key, "Position") == 0) {
-			PushVector3(L, Position.x, Position.y, Position.z);
-			return true;
-		}
+	// bounds of the shape's mesh before the transform is applied
+	// raylib's cylinder mesh starts at its origin instead of being centered
+	BoundingBox GetLocalBounds() const {
+		if (ShapeType == PART_SHAPE_CYLINDER)
+			return {{-0.5f, 0.0f, -0.5f}, {0.5f, 1.0f, 0.5f}};
 
-		if (std::strcmp(key, "Rotation") == 0) {
-			PushVector3(L, Rotation.x, Rotation.y, Rotation.z);
-			return true;
-		}
+		return {{-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}};
+	}
 
-		if (std::strcmp(key, "Size") == 0) {
-			PushVector3(L, Size.x, Size.y, Size.z);
-			return true;
-		}
+	void UpdateTransform() {
+		if (!transformDirty) return;
 
-		if (std::strcmp(key, "Velocity") == 0) {
-			PushVector3(L, Velocity.x, Velocity.y, Velocity.z);
-			return true;
-		}
+		transform = MatrixMultiply(
+			MatrixScale(Size.x, Size.y, Size.z),
+			MatrixRotateXYZ({Rotation.x * DEG2RAD, Rotation.y * DEG2RAD, Rotation.z * DEG2RAD})
+		);
 
-		if (std::strcmp(key, "Color") == 0) {
-			PushColor3(L, (float)color.r / 255, (float)color.g / 255, (float)color.b / 255);
-			return true;
-		}
+		transform = MatrixMultiply(transform, MatrixTranslate(Position.x, Position.y, Position.z));
 
-		if (std::strcmp(key, "Transparency") == 0) {
-			lua_pushnumber(L, 1.f - (float)color.a / 255);
-			return true;
-		}
+		// transform the local box center, then grow the extents by the absolute basis
+		BoundingBox local = GetLocalBounds();
+		Vector3 center = Vector3Transform(Vector3Scale(Vector3Add(local.min, local.max), 0.5f), transform);
+		Vector3 half = Vector3Scale(Vector3Subtract(local.max, local.min), 0.5f);
 
-		if (std::strcmp(key, "Shape") == 0) {
-			lua_pushstring(L, Shape.data());
-			return true;
-		}
+		Vector3 extents = {
+			fabsf(transform.m0) * half.x + fabsf(transform.m4) * half.y + fabsf(transform.m8) * half.z,
+			fabsf(transform.m1) * half.x + fabsf(transform.m5) * half.y + fabsf(transform.m9) * half.z,
+			fabsf(transform.m2) * half.x + fabsf(transform.m6) * half.y + fabsf(transform.m10) * half.z,
+		};
 
-		if (std::strcmp(key, "Anchored") == 0) {
-			lua_pushboolean(L, Anchored);
-			return true;
-		}
+		bounds = {Vector3Subtract(center, extents), Vector3Add(center, extents)};
+		transformDirty = false;
+	}
 
-		return Instance::LuaGet(L, key);
+	const Matrix& GetTransform() {
+		UpdateTransform();
+		return transform;
 	}
 
-	bool LuaSet(lua_State *L, const char *key, int valueIndex) override {
-		if (std::strcmp(key, "Position") == 0) {
-			Position = RaylibVector3FromLuaVector3(*CheckVector3(L, valueIndex));
-			return true;
-		}
+	const BoundingBox& GetBounds() {
+		UpdateTransform();
+		return bounds;
+	}
 
-		if (std::strcmp(key, "Rotation") == 0) {
-			Rotation = RaylibVector3FromLuaVector3(*CheckVector3(L, valueIndex));
-			return true;
-		}
+	// world space ray test against the actual shape, direction must be normalized
+	// like roblox, a ray that starts inside the part doesn't hit it
+	bool Raycast(Vector3 origin, Vector3 direction, float maxDistance, RayCollision& hit) {
+		Matrix inverse = MatrixInvert(GetTransform());
 
-		if (std::strcmp(key, "Size") == 0) {
-			Size = RaylibVector3FromLuaVector3(*CheckVector3(L, valueIndex));
-			return true;
-		}
+		// the scale stays in the local direction, so t is still the world distance
+		Vector3 o = Vector3Transform(origin, inverse);
+		Vector3 d = {
+			inverse.m0 * direction.x + inverse.m4 * direction.y + inverse.m8 * direction.z,
+			inverse.m1 * direction.x + inverse.m5 * direction.y + inverse.m9 * direction.z,
+			inverse.m2 * direction.x + inverse.m6 * direction.y + inverse.m10 * direction.z,
+		};
 
-		if (std::strcmp(key, "Velocity") == 0) {
-			Velocity = RaylibVector3FromLuaVector3(*CheckVector3(L, valueIndex));
-			return true;
-		}
+		float t = -1.0f;
+		Vector3 normal = {0, 0, 0};
 
-		if (std::strcmp(key, "Color") == 0) {
-			LuaColor3 *clr = CheckColor3(L, valueIndex);
+		switch (ShapeType) {
+			case PART_SHAPE_BALL: {
+				float a = Vector3DotProduct(d, d);
+				float b = Vector3DotProduct(o, d);
+				float c = Vector3DotProduct(o, o) - 0.25f;
+				float disc = b*b - a*c;
 
-			color.r = (unsigned char)(clr->r * 255);
-			color.g = (unsigned char)(clr->g * 255);
-			color.b = (unsigned char)(clr->b * 255);
+				if (c < 0.0f || disc < 0.0f) return false;
 
-			return true;
-		}
+				t = (-b - sqrtf(disc)) / a;
+				normal = Vector3Add(o, Vector3Scale(d, t));
+				break;
+			}
 
-		if (std::strcmp(key, "Transparency") == 0) {
-			float transparency = static_cast<float>(luaL_checknumber(L, valueIndex));
-			color.a = (unsigned char)((1.f - std::clamp(transparency, 0.f, 1.f)) * 255);
-			return true;
-		}
+			case PART_SHAPE_CYLINDER: {
+				// side is x^2 + z^2 = 0.25 between the caps at y = 0 and y = 1
+				if (o.x*o.x + o.z*o.z <= 0.25f && o.y >= 0.0f && o.y <= 1.0f) return false;
 
-		if (std::strcmp(key, "Shape") == 0) {
-			Shape = luaL_checkstring(L, valueIndex);
-			return true;
-		}
+				float a = d.x*d.x + d.z*d.z;
+				float b = o.x*d.x + o.z*d.z;
+				float c = o.x*o.x + o.z*o.z - 0.25f;
+				float disc = b*b - a*c;
+
+				if (a > 1e-8f && disc >= 0.0f) {
+					float side = (-b - sqrtf(disc)) / a;
+					float y = o.y + side * d.y;
+
+					if (side >= 0.0f && y >= 0.0f && y <= 1.0f) {
+						t = side;
+						normal = {o.x + side * d.x, 0.0f, o.z + side * d.z};
+					}
+				}
+
+				if (fabsf(d.y) > 1e-8f) {
+					for (float cap : {0.0f, 1.0f}) {
+						float capT = (cap - o.y) / d.y;
+						if (capT < 0.0f || (t >= 0.0f && capT >= t)) continue;
+
+						Vector3 p = Vector3Add(o, Vector3Scale(d, capT));
+						if (p.x*p.x + p.z*p.z > 0.25f) continue;
+
+						t = capT;
+						normal = {0.0f, cap == 0.0f ? -1.0f : 1.0f, 0.0f};
+					}
+				}
+
+				break;
+			}
+
+			default: {
+				const float ov[3] = {o.x, o.y, o.z};
+				const float dv[3] = {d.x, d.y, d.z};
+
+				float tmin = -INFINITY;
+				float tmax = INFINITY;
+				int axis = -1;
+				float sign = 0.0f;
+
+				for (int i = 0; i < 3; i++) {
+					if (fabsf(dv[i]) < 1e-8f) {
+						if (ov[i] < -0.5f || ov[i] > 0.5f) return false;
+						continue;
+					}
+
+					float t1 = (-0.5f - ov[i]) / dv[i];
+					float t2 = (0.5f - ov[i]) / dv[i];
+					float s = -1.0f;
 
-		if (std::strcmp(key, "Anchored") == 0) {
-			Anchored = luaL_checkboolean(L, valueIndex);
-			return true;
+					if (t1 > t2) {
+						std::swap(t1, t2);
+						s = 1.0f;
+					}
+
+					if (t1 > tmin) {
+						tmin = t1;
+						axis = i;
+						sign = s;
+					}
+
+					tmax = std::min(tmax, t2);
+					if (tmin > tmax) return false;
+				}
+
+				if (axis < 0 || tmin < 0.0f) return false;
+
+				t = tmin;
+				if (axis == 0) normal.x = sign;
+				if (axis == 1) normal.y = sign;
+				if (axis == 2) normal.z = sign;
+				break;
+			}
 		}
 
-		return Instance::LuaSet(L, key, valueIndex);
+		if (t < 0.0f || t > maxDistance) return false;
+
+		// normals go through the inverse transpose to survive non uniform sizes
+		Vector3 worldNormal = {
+			inverse.m0 * normal.x + inverse.m1 * normal.y + inverse.m2 * normal.z,
+			inverse.m4 * normal.x + inverse.m5 * normal.y + inverse.m6 * normal.z,
+			inverse.m8 * normal.x + inverse.m9 * normal.y + inverse.m10 * normal.z,
+		};
+
+		hit.hit = true;
+		hit.distance = t;
+		hit.point = Vector3Add(origin, Vector3Scale(direction, t));
+		hit.normal = Vector3Normalize(worldNormal);
+		return true;
+	}
+
+	static const LuaPropertyTable& ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_Position,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					PushVector3(L, self->Position.x, self->Position.y, self->Position.z);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Position = RaylibVector3FromLuaVector3(*CheckVector3(L, idx));
+					self->transformDirty = true;
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Rotation,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					PushVector3(L, self->Rotation.x, self->Rotation.y, self->Rotation.z);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Rotation = RaylibVector3FromLuaVector3(*CheckVector3(L, idx));
+					self->transformDirty = true;
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Size,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					PushVector3(L, self->Size.x, self->Size.y, self->Size.z);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Size = RaylibVector3FromLuaVector3(*CheckVector3(L, idx));
+					self->transformDirty = true;
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Velocity,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					PushVector3(L, self->Velocity.x, self->Velocity.y, self->Velocity.z);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Velocity = RaylibVector3FromLuaVector3(*CheckVector3(L, idx));
+				}},
+			{ATOM_Color,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					PushColor3(L, (float)self->color.r / 255, (float)self->color.g / 255, (float)self->color.b / 255);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					LuaColor3 *clr = CheckColor3(L, idx);
+
+					self->color.r = (unsigned char)(clr->r * 255);
+					self->color.g = (unsigned char)(clr->g * 255);
+					self->color.b = (unsigned char)(clr->b * 255);
+
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Transparency,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					lua_pushnumber(L, 1.f - (float)self->color.a / 255);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					float transparency = static_cast<float>(luaL_checknumber(L, idx));
+					self->color.a = (unsigned char)((1.f - std::clamp(transparency, 0.f, 1.f)) * 255);
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Shape,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					lua_pushstring(L, self->Shape.data());
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Shape = luaL_checkstring(L, idx);
+					self->ShapeType = PartShapeFromString(self->Shape);
+					self->transformDirty = true;
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Anchored,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					lua_pushboolean(L, self->Anchored);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Anchored = luaL_checkboolean(L, idx);
+					self->NotifyAncestorsChanged();
+				}},
+			{ATOM_Material,
+				[](lua_State *L, Instance *obj) {
+					Part *self = static_cast<Part *>(obj);
+					lua_pushstring(L, self->Material.data());
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					Part *self = static_cast<Part *>(obj);
+					self->Material = luaL_checkstring(L, idx);
+					self->MaterialType = PartMaterialFromString(self->Material);
+					self->NotifyAncestorsChanged();
+				}},
+		};
+
+		static const LuaPropertyTable table(&Instance::ClassProperties(), own);
+		return table;
+	}
+
+	const LuaPropertyTable &Properties() const override {
+		return ClassProperties();
 	}
 };
\ No newline at end of file
@@ -18,41 +18,39 @@ struct ScreenGui : public Cloneable<ScreenGui, Instance> {
 		return "ScreenGui";
 	}
 
-	bool LuaGet(lua_State *L, const char *key) override {
-		if (std::strcmp(key, "Enabled") == 0) {
-			lua_pushboolean(L, Enabled);
-			return true;
-		}
-
-		if (std::strcmp(key, "IgnoreGuiInset") == 0) {
-			lua_pushboolean(L, IgnoreGuiInset);
-			return true;
-		}
-
-		if (std::strcmp(key, "AbsolutePosition") == 0) {
-			lua_pushvector(L, 0, 0, 0);
-			return true;
-		}
-
-		if (std::strcmp(key, "AbsoluteSize") == 0) {
-			lua_pushvector(L, GetScreenWidth(), GetScreenHeight(), 0);
-			return true;
-		}
-
-		return Instance::LuaGet(L, key);
+	static const LuaPropertyTable &ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_Enabled,
+				[](lua_State *L, Instance *obj) {
+					ScreenGui *self = static_cast<ScreenGui *>(obj);
+					lua_pushboolean(L, self->Enabled);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					ScreenGui *self = static_cast<ScreenGui *>(obj);
+					self->Enabled = luaL_checkboolean(L, idx);
+				}},
+			{ATOM_IgnoreGuiInset,
+				[](lua_State *L, Instance *obj) {
+					ScreenGui *self = static_cast<ScreenGui *>(obj);
+					lua_pushboolean(L, self->IgnoreGuiInset);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					ScreenGui *self = static_cast<ScreenGui *>(obj);
+					self->IgnoreGuiInset = luaL_checkboolean(L, idx);
+				}},
+			{ATOM_AbsolutePosition,
+				[](lua_State *L, Instance *obj) { lua_pushvector(L, 0, 0, 0); },
+				nullptr},
+			{ATOM_AbsoluteSize,
+				[](lua_State *L, Instance *obj) { lua_pushvector(L, GetScreenWidth(), GetScreenHeight(), 0); },
+				nullptr},
+		};
+
+		static const LuaPropertyTable table(&Instance::ClassProperties(), own);
+		return table;
 	}
 
-	bool LuaSet(lua_State *L, const char *key, int valueIndex) override {
-		if (std::strcmp(key, "Enabled") == 0) {
-			Enabled = luaL_checkboolean(L, valueIndex);
-			return true;
-		}
-
-		if (std::strcmp(key, "IgnoreGuiInset") == 0) {
-			IgnoreGuiInset = luaL_checkboolean(L, valueIndex);
-			return true;
-		}
-
-		return Instance::LuaSet(L, key, valueIndex);
+	const LuaPropertyTable &Properties() const override {
+		return ClassProperties();
 	}
 };
\ No newline at end of file
@@ -8,6 +8,11 @@
 
 // name has to be different since raylib defines its own "Sound" struct
 
+struct ObjectSound;
+
+// every live Sound, so their streams are fed without walking the tree
+extern SlotMap<ObjectSound> gSounds;
+
 struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 	std::string Name = "Sound";
 	std::string SoundId = "";
@@ -22,15 +27,60 @@ struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 	// bool IsPlaying = false;
 	bool Looped = false;
 
+	SlotHandle SoundHandle;
+
 	ObjectSound() {
 		music = {};
 		music.looping = false;
+
+		SoundHandle = gSounds.Insert(this);
+	}
+
+	// clones get their own stream, sharing one would unload it twice
+	ObjectSound(const ObjectSound& other)
+		: Cloneable<ObjectSound, Instance>(other), Name(other.Name), SoundId(other.SoundId),
+		  PlaybackSpeed(other.PlaybackSpeed), Volume(other.Volume), Looped(other.Looped) {
+		music = {};
+		IsLoaded = false;
+		LoadSound();
+
+		SoundHandle = gSounds.Insert(this);
+	}
+
+	~ObjectSound() override {
+		gSounds.Erase(SoundHandle);
+		UnloadSound();
 	}
 
 	const char* ClassName() const override {
 		return "Sound";
 	}
 
+	void UnloadSound() {
+		if (IsLoaded && IsMusicValid(music)) {
+			UnloadMusicStream(music);
+			IsLoaded = false;
+		}
+	}
+
+	void LoadSound() {
+		UnloadSound();
+
+		// headless runs never open the audio device
+		if (SoundId.empty() || !IsAudioDeviceReady())
+			return;
+
+		music = LoadMusicStream(SoundId.data());
+		music.looping = Looped;
+
+		IsLoaded = IsMusicValid(music);
+
+		if (IsLoaded) {
+			SetMusicVolume(music, Volume);
+			SetMusicPitch(music, PlaybackSpeed);
+		}
+	}
+
 	void Update() {
 		UpdateMusicStream(music);
 	}
@@ -64,7 +114,7 @@ struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 	}
 
 	static int l_Play(lua_State *L) {
-		ObjectSound *self = *(ObjectSound **)luaL_checkudata(L, 1, "Instance");
+		ObjectSound *self = static_cast<ObjectSound *>(CheckInstance(L, 1));
 		if (!self) return 0;
 		
 		self->Play();
@@ -72,7 +122,7 @@ struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 	}
 
 	static int l_Stop(lua_State *L) {
-		ObjectSound *self = *(ObjectSound **)luaL_checkudata(L, 1, "Instance");
+		ObjectSound *self = static_cast<ObjectSound *>(CheckInstance(L, 1));
 		if (!self) return 0;
 
 		self->Stop();
@@ -80,7 +130,7 @@ struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 	}
 
 	static int l_Pause(lua_State *L) {
-		ObjectSound *self = *(ObjectSound **)luaL_checkudata(L, 1, "Instance");
+		ObjectSound *self = static_cast<ObjectSound *>(CheckInstance(L, 1));
 		if (!self) return 0;
 		
 		self->Pause();
@@ -88,7 +138,7 @@ struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 	}
 
 	static int l_Resume(lua_State *L) {
-		ObjectSound *self = *(ObjectSound **)luaL_checkudata(L, 1, "Instance");
+		ObjectSound *self = static_cast<ObjectSound *>(CheckInstance(L, 1));
 		if (!self) return 0;
 		
 		self->Resume();
@@ -181,24 +231,19 @@ struct ObjectSound : public Cloneable<ObjectSound, Instance> {
 		return Instance::LuaGet(L, key);
 	}
 
+	lua_CFunction LuaMethod(int atom) override {
+		switch (atom) {
+			case ATOM_Play: return l_Play;
+			case ATOM_Stop: return l_Stop;
+		}
+
+		return Instance::LuaMethod(atom);
+	}
+
 	bool LuaSet(lua_State *L, const char *key, int valueIndex) override {
 		if (std::strcmp(key, "SoundId") == 0) {
 			SoundId = luaL_checkstring(L, valueIndex);
-
-			if (IsLoaded && IsMusicValid(music)) {
-				UnloadMusicStream(music);
-				IsLoaded = false;
-			}
-
-			music = LoadMusicStream(SoundId.data());
-			music.looping = Looped;
-
-			IsLoaded = IsMusicValid(music);
-
-			if (IsLoaded) {
-				SetMusicVolume(music, Volume);
-				SetMusicPitch(music, PlaybackSpeed);
-			}
+			LoadSound();
 
 			return true;
 		}
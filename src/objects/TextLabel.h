@@ -21,52 +21,52 @@ struct TextLabel : public Cloneable<TextLabel, GuiObject> {
 		return "TextLabel";
 	}
 
-	bool LuaGet(lua_State *L, const char *key) override {
-		if (std::strcmp(key, "Text") == 0) {
-			lua_pushstring(L, Text.data());
-			return true;
-		}
-
-		if (std::strcmp(key, "TextColor") == 0) {
-			PushColor3(L, TextColor.r, TextColor.g, TextColor.b);
-			return true;
-		}
-
-		if (std::strcmp(key, "TextTransparency") == 0) {
-			lua_pushnumber(L, static_cast<double>(TextTransparency));
-			return true;
-		}
-
-		if (std::strcmp(key, "TextSize") == 0) {
-			lua_pushnumber(L, static_cast<double>(TextSize));
-			return true;
-		}
-
-		return GuiObject::LuaGet(L, key);
+	static const LuaPropertyTable &ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_Text,
+				[](lua_State *L, Instance *obj) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					lua_pushstring(L, self->Text.data());
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					self->Text = luaL_checkstring(L, idx);
+				}},
+			{ATOM_TextColor,
+				[](lua_State *L, Instance *obj) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					PushColor3(L, self->TextColor.r, self->TextColor.g, self->TextColor.b);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					self->TextColor = *CheckColor3(L, idx);
+				}},
+			{ATOM_TextTransparency,
+				[](lua_State *L, Instance *obj) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					lua_pushnumber(L, static_cast<double>(self->TextTransparency));
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					self->TextTransparency = static_cast<float>(luaL_checknumber(L, idx));
+				}},
+			{ATOM_TextSize,
+				[](lua_State *L, Instance *obj) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					lua_pushnumber(L, static_cast<double>(self->TextSize));
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					TextLabel *self = static_cast<TextLabel *>(obj);
+					self->TextSize = static_cast<float>(luaL_checknumber(L, idx));
+				}},
+		};
+
+		static const LuaPropertyTable table(&GuiObject::ClassProperties(), own);
+		return table;
 	}
 
-	bool LuaSet(lua_State *L, const char *key, int valueIndex) override {
-		if (std::strcmp(key, "Text") == 0) {
-			Text = luaL_checkstring(L, valueIndex);
-			return true;
-		}
-
-		if (std::strcmp(key, "TextColor") == 0) {
-			TextColor = *CheckColor3(L, valueIndex);
-			return true;
-		}
-
-		if (std::strcmp(key, "TextTransparency") == 0) {
-			TextTransparency = static_cast<float>(luaL_checknumber(L, valueIndex));
-			return true;
-		}
-
-		if (std::strcmp(key, "TextSize") == 0) {
-			TextSize = static_cast<float>(luaL_checknumber(L, valueIndex));
-			return true;
-		}
-
-		return GuiObject::LuaSet(L, key, valueIndex);
+	const LuaPropertyTable &Properties() const override {
+		return ClassProperties();
 	}
 
 	void Draw(Rectangle rect, Color color) override {
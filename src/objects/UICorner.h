@@ -13,21 +13,24 @@ struct UICorner : public Cloneable<UICorner, Instance> {
 		return "UICorner";
 	}
 
-	bool LuaGet(lua_State *L, const char *key) override {
-		if (std::strcmp(key, "CornerRadius") == 0) {
-			PushUDim(L, CornerRadius.scale, CornerRadius.offset);
-			return true;
-		}
-
-		return Instance::LuaGet(L, key);
+	static const LuaPropertyTable &ClassProperties() {
+		static constexpr LuaProperty own[] = {
+			{ATOM_CornerRadius,
+				[](lua_State *L, Instance *obj) {
+					UICorner *self = static_cast<UICorner *>(obj);
+					PushUDim(L, self->CornerRadius.scale, self->CornerRadius.offset);
+				},
+				[](lua_State *L, Instance *obj, int idx) {
+					UICorner *self = static_cast<UICorner *>(obj);
+					self->CornerRadius = *CheckUDim(L, idx);
+				}},
+		};
+
+		static const LuaPropertyTable table(&Instance::ClassProperties(), own);
+		return table;
 	}
 
-	bool LuaSet(lua_State *L, const char *key, int index) override {
-		if (std::strcmp(key, "CornerRadius") == 0) {
-			CornerRadius = *CheckUDim(L, index);
-			return true;
-		}
-
-		return Instance::LuaSet(L, key, index);
+	const LuaPropertyTable &Properties() const override {
+		return ClassProperties();
 	}
 };
\ No newline at end of file
@@ -5,11 +5,12 @@
 #include "objects/Instance.h"
 #include "Service.h"
 #include "raylib.h"
+#include "core/RuntimeClock.h"
 #include <algorithm>
 #include <cstring>
 
 struct DebrisData {
-	Instance* instance;
+	SlotHandle instance;
 	double destroyTime;
 };
 
@@ -22,28 +23,30 @@ struct Debris : Service {
 
 	void AddItem(Instance* instance, double lifetime) {
 		items.push_back((DebrisData){
-			instance,
-			GetTime() + lifetime
+			instance->Handle,
+			GetRuntimeTime() + lifetime
 		});
 	}
 
 	void UpdateDebris() {
-		double time = GetTime();
-		for( DebrisData& item : items) {
-			if (item.destroyTime <= time) {
-				if (item.instance) {
-
-					if (!item.instance->ParentingLocked)
-						item.instance->Destroy();
-				}
-			}
-		}
+		double time = GetRuntimeTime();
 
 		items.erase(std::remove_if(
 			items.begin(),
 			items.end(),
-			[&](DebrisData& d) {
-				return d.destroyTime <= GetTime();
+			[&](DebrisData& item) {
+				// freed or destroyed by something else already
+				Instance* instance = gInstances.Get(item.instance);
+				if (!instance || instance->Destroyed)
+					return true;
+
+				if (item.destroyTime > time)
+					return false;
+
+				if (!instance->ParentingLocked)
+					instance->Destroy();
+
+				return true;
 			}
 		), items.end());
 	}
@@ -53,7 +56,7 @@ struct Debris : Service {
 	}
 
 	static int l_AddItem(lua_State* L) {
-		auto* serv = *(Debris**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<Debris*>(CheckInstance(L, 1));
 		Instance* inst = CheckInstance(L, 2);
 
 		double lifetime = luaL_optnumber(L, 3, 0);
@@ -72,4 +75,13 @@ struct Debris : Service {
 
 		return Service::LuaGet(L, key);
 	}
+
+	lua_CFunction LuaMethod(int atom) override {
+		switch (atom) {
+			case ATOM_AddItem:
+			case ATOM_addItem: return l_AddItem;
+		}
+
+		return Service::LuaMethod(atom);
+	}
 };
@@ -90,7 +90,7 @@ struct DebugVisualService : Service {
     }
 
 	static int l_DrawText(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugTextCmd c;
 		c.text = luaL_checkstring(L, 2);
@@ -103,7 +103,7 @@ struct DebugVisualService : Service {
 	}
 
 	static int l_DrawLine2D(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugLine2DCmd c;
 		c.from = *CheckUDim2(L, 2);
@@ -116,7 +116,7 @@ struct DebugVisualService : Service {
 	}
 
 	static int l_DrawArrow2D(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugLine2DCmd c;
 		c.isArrow = true;
@@ -130,7 +130,7 @@ struct DebugVisualService : Service {
 	}
 
 	static int l_DrawLine3D(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugLine3DCmd c;
 		c.isArrow = false;
@@ -143,7 +143,7 @@ struct DebugVisualService : Service {
 	}
 
 	static int l_DrawArrow3D(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugLine3DCmd c;
 		c.isArrow = true;
@@ -158,7 +158,7 @@ struct DebugVisualService : Service {
 	}
 
 	static int l_DrawRectangle(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugRectangleCmd c;
 		c.position = *CheckUDim2(L, 2);
@@ -173,7 +173,7 @@ struct DebugVisualService : Service {
 	}
 
 	static int l_DrawRectangleOutline(lua_State* L) {
-		auto* serv = *(DebugVisualService**)luaL_checkudata(L, 1, "Instance");
+		auto* serv = static_cast<DebugVisualService*>(CheckInstance(L, 1));
 
 		DebugRectangleCmd c;
 		c.position = *CheckUDim2(L, 2);
@@ -225,6 +225,20 @@ struct DebugVisualService : Service {
 
 		return Instance::LuaGet(L, key);
 	}
+
+	lua_CFunction LuaMethod(int atom) override {
+		switch (atom) {
+			case ATOM_DrawText: return l_DrawText;
+			case ATOM_DrawLine2D: return l_DrawLine2D;
+			case ATOM_DrawArrow2D: return l_DrawArrow2D;
+			case ATOM_DrawLine3D: return l_DrawLine3D;
+			case ATOM_DrawArrow3D: return l_DrawArrow3D;
+			case ATOM_DrawRectangle: return l_DrawRectangle;
+			case ATOM_DrawRectangleOutline: return l_DrawRectangleOutline;
+		}
+
+		return Instance::LuaMethod(atom);
+	}
 };
 
 static void DebugDrawText2D(DebugTextCmd cmd, Vector2 screenBounds) {
@@ -28,7 +28,7 @@ struct Lighting : Service {
     }
 
 	static int l_GetSunDirection(lua_State* L) {
-		Lighting* lighting = *(Lighting**)luaL_checkudata(L, 1, "Instance");
+		Lighting* lighting = static_cast<Lighting*>(CheckInstance(L, 1));
 
 		Vector3 sunDir = SunDirFromClock(lighting->ClockTime);
 		lua_pushvector(L, sunDir.x, sunDir.y, sunDir.z);
@@ -53,7 +53,7 @@ struct Lighting : Service {
 		}
 
 		if (std::strcmp(key, "GlobalShadows") == 0) {
-			lua_pushnumber(L, static_cast<double>(GlobalShadows));
+			lua_pushboolean(L, GlobalShadows);
 			return true;
 		}
 
@@ -69,6 +69,13 @@ struct Lighting : Service {
 		
 		return Instance::LuaGet(L, key);
 	}
+
+	lua_CFunction LuaMethod(int atom) override {
+		if (atom == ATOM_GetSunDirection)
+			return l_GetSunDirection;
+
+		return Instance::LuaMethod(atom);
+	}
 	
 	bool LuaSet(lua_State* L, const char* key, int valueIndex) override {
 		if (std::strcmp(key, "Brightness") == 0) {
@@ -1,8 +1,41 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
 #include "Service.h"
+#include "objects/Part.h"
+#include "datatypes/LuaCFrame.h"
+#include "datatypes/LuaVector3.h"
+#include "utils/AABBTree.h"
+#include "utils/VecMath.h"
+
+// anchored parts grouped by area, the renderer merges each chunk into one mesh
+// and only rebuilds it while Dirty is set
+struct StaticChunk {
+	std::vector<Part*> Parts;
+	bool Dirty = true;
+};
 
 struct Workspace : Service {
+	// unanchored parts in the workspace subtree, kept up to date on reparent
+	// so the renderer iterates a dense array instead of walking the tree
+	std::vector<Part*> RenderParts;
+
+	// anchored parts, keyed by StaticChunkKey
+	std::unordered_map<uint64_t, StaticChunk> StaticChunks;
+	static constexpr float StaticChunkSize = 64.0f;
+
+	// BVH over every part for Raycast and GetPartBoundsInBox
+	AABBTree PartTree;
+
+	// bumped whenever an anchored part is added, removed or changed,
+	// the renderer compares it to decide if cached static data is stale
+	unsigned int StaticVersion = 0;
+
     Workspace() {
         Name = "Workspace";
     }
@@ -10,4 +43,259 @@ struct Workspace : Service {
     const char* ClassName() const override {
         return "Workspace";
     }
+
+	// 21 bits per axis, enough for about 67 million studs each way
+	static uint64_t StaticChunkKey(Part* part) {
+		const BoundingBox& bounds = part->GetBounds();
+
+		auto cell = [](float min, float max) {
+			int64_t index = (int64_t)floorf((min + max) * 0.5f / StaticChunkSize);
+			return (uint64_t)index & 0x1FFFFF;
+		};
+
+		return cell(bounds.min.x, bounds.max.x) |
+			   cell(bounds.min.y, bounds.max.y) << 21 |
+			   cell(bounds.min.z, bounds.max.z) << 42;
+	}
+
+	static void SwapRemovePart(std::vector<Part*>& parts, Part* part) {
+		int index = part->renderIndex;
+
+		if (index >= 0 && index < (int)parts.size() && parts[index] == part) {
+			Part* last = parts.back();
+			parts[index] = last;
+			last->renderIndex = index;
+			parts.pop_back();
+		}
+	}
+
+	// files the part under RenderParts or its static chunk depending on Anchored
+	void FilePart(Part* part) {
+		part->inStaticChunk = part->Anchored;
+
+		if (!part->Anchored) {
+			part->renderIndex = (int)RenderParts.size();
+			RenderParts.push_back(part);
+			return;
+		}
+
+		part->chunkKey = StaticChunkKey(part);
+
+		StaticChunk& chunk = StaticChunks[part->chunkKey];
+		part->renderIndex = (int)chunk.Parts.size();
+		chunk.Parts.push_back(part);
+		chunk.Dirty = true;
+
+		StaticVersion++;
+	}
+
+	void UnfilePart(Part* part) {
+		if (part->renderIndex == -1) return;
+
+		if (!part->inStaticChunk) {
+			SwapRemovePart(RenderParts, part);
+		} else {
+			auto it = StaticChunks.find(part->chunkKey);
+
+			if (it != StaticChunks.end()) {
+				SwapRemovePart(it->second.Parts, part);
+				it->second.Dirty = true;
+
+				if (it->second.Parts.empty())
+					StaticChunks.erase(it);
+			}
+
+			StaticVersion++;
+		}
+
+		part->renderIndex = -1;
+	}
+
+	void DescendantAdded(Instance* descendant) override {
+		if (Part* part = dynamic_cast<Part*>(descendant)) {
+			FilePart(part);
+
+			if (part->treeProxy == -1)
+				part->treeProxy = PartTree.CreateProxy(part->GetBounds(), part);
+		}
+
+		for (Instance* child : descendant->Children)
+			DescendantAdded(child);
+	}
+
+	void DescendantRemoving(Instance* descendant) override {
+		if (Part* part = dynamic_cast<Part*>(descendant)) {
+			UnfilePart(part);
+
+			if (part->treeProxy != -1) {
+				PartTree.DestroyProxy(part->treeProxy);
+				part->treeProxy = -1;
+			}
+		}
+
+		for (Instance* child : descendant->Children)
+			DescendantRemoving(child);
+	}
+
+	void DescendantChanged(Instance* descendant) override {
+		Part* part = dynamic_cast<Part*>(descendant);
+		if (!part || part->renderIndex == -1) return;
+
+		if (part->treeProxy != -1)
+			PartTree.MoveProxy(part->treeProxy, part->GetBounds());
+
+		// refiling picks up moves between chunks and Anchored being toggled
+		if (part->Anchored || part->inStaticChunk) {
+			UnfilePart(part);
+			FilePart(part);
+		}
+	}
+
+	// closest part hit within the length of direction, filter is matched against the part and its ancestors
+	Part* Raycast(Vector3 origin, Vector3 direction, const std::vector<Instance*>& filter, bool include, RayCollision& result) {
+		float length = Vector3Length(direction);
+		if (length <= 0.0f) return nullptr;
+
+		Vector3 dir = Vector3Scale(direction, 1.0f / length);
+		Part* closest = nullptr;
+
+		PartTree.RayCast(origin, dir, length, [&](void* userData, float maxDistance) {
+			Part* part = static_cast<Part*>(userData);
+
+			if (!filter.empty() && IsFiltered(part, filter) != include)
+				return maxDistance;
+
+			RayCollision hit{};
+			if (!part->Raycast(origin, dir, maxDistance, hit))
+				return maxDistance;
+
+			closest = part;
+			result = hit;
+			return hit.distance;
+		});
+
+		return closest;
+	}
+
+	static bool IsFiltered(Instance* inst, const std::vector<Instance*>& filter) {
+		for (Instance* current = inst; current; current = current->Parent) {
+			for (Instance* filtered : filter) {
+				if (current == filtered)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	static int l_Raycast(lua_State* L) {
+		auto* serv = static_cast<Workspace*>(CheckInstance(L, 1));
+		Vector3 origin = RaylibVector3FromLuaVector3(*CheckVector3(L, 2));
+		Vector3 direction = RaylibVector3FromLuaVector3(*CheckVector3(L, 3));
+
+		std::vector<Instance*> filter;
+		bool include = false;
+
+		if (lua_istable(L, 4)) {
+			lua_getfield(L, 4, "FilterDescendantsInstances");
+			if (lua_istable(L, -1)) {
+				int count = lua_objlen(L, -1);
+
+				for (int i = 1; i <= count; i++) {
+					lua_rawgeti(L, -1, i);
+					filter.push_back(CheckInstance(L, -1));
+					lua_pop(L, 1);
+				}
+			}
+			lua_pop(L, 1);
+
+			lua_getfield(L, 4, "FilterType");
+			if (lua_isstring(L, -1))
+				include = std::strcmp(lua_tostring(L, -1), "Include") == 0;
+			lua_pop(L, 1);
+		}
+
+		// an empty include list can't hit anything
+		if (include && filter.empty()) {
+			lua_pushnil(L);
+			return 1;
+		}
+
+		RayCollision hit{};
+		Part* part = serv->Raycast(origin, direction, filter, include, hit);
+
+		if (!part) {
+			lua_pushnil(L);
+			return 1;
+		}
+
+		lua_newtable(L);
+		PushInstance(L, part); lua_setfield(L, -2, "Instance");
+		PushVector3(L, hit.point.x, hit.point.y, hit.point.z); lua_setfield(L, -2, "Position");
+		PushVector3(L, hit.normal.x, hit.normal.y, hit.normal.z); lua_setfield(L, -2, "Normal");
+		lua_pushnumber(L, hit.distance); lua_setfield(L, -2, "Distance");
+
+		return 1;
+	}
+
+	static int l_GetPartBoundsInBox(lua_State* L) {
+		auto* serv = static_cast<Workspace*>(CheckInstance(L, 1));
+		LuaCFrame* cframe = CheckCFrame(L, 2);
+		Vector3 size = RaylibVector3FromLuaVector3(*CheckVector3(L, 3));
+
+		Vector3 center = CFrameGetPosition(*cframe);
+		Vector3 axes[3] = {
+			Vector3Normalize(CFrameGetRight(*cframe)),
+			Vector3Normalize(CFrameGetUp(*cframe)),
+			Vector3Normalize(CFrameGetBack(*cframe)),
+		};
+		Vector3 half = Vector3Scale(size, 0.5f);
+
+		// world AABB of the query box for the broad phase
+		Vector3 extents = {
+			fabsf(axes[0].x) * half.x + fabsf(axes[1].x) * half.y + fabsf(axes[2].x) * half.z,
+			fabsf(axes[0].y) * half.x + fabsf(axes[1].y) * half.y + fabsf(axes[2].y) * half.z,
+			fabsf(axes[0].z) * half.x + fabsf(axes[1].z) * half.y + fabsf(axes[2].z) * half.z,
+		};
+		BoundingBox queryBox = {Vector3Subtract(center, extents), Vector3Add(center, extents)};
+
+		lua_newtable(L);
+		int i = 1;
+
+		serv->PartTree.Query(queryBox, [&](void* userData) {
+			Part* part = static_cast<Part*>(userData);
+
+			if (OrientedBoxOverlapsBox(center, axes, half, part->GetBounds())) {
+				PushInstance(L, part);
+				lua_rawseti(L, -2, i++);
+			}
+
+			return true;
+		});
+
+		return 1;
+	}
+
+	bool LuaGet(lua_State* L, const char* key) override {
+		if (std::strcmp(key, "Raycast") == 0) {
+			lua_pushcfunction(L, l_Raycast, "Workspace:Raycast");
+			return true;
+		}
+
+		if (std::strcmp(key, "GetPartBoundsInBox") == 0) {
+			lua_pushcfunction(L, l_GetPartBoundsInBox, "Workspace:GetPartBoundsInBox");
+			return true;
+		}
+
+		return Service::LuaGet(L, key);
+	}
+
+	lua_CFunction LuaMethod(int atom) override {
+		switch (atom) {
+			case ATOM_Raycast: return l_Raycast;
+			case ATOM_GetPartBoundsInBox: return l_GetPartBoundsInBox;
+		}
+
+		return Service::LuaMethod(atom);
+	}
 };
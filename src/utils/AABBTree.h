@@ -0,0 +1,403 @@
+#pragma once
+
+#include <raylib.h>
+#include <raymath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// dynamic AABB tree (bounding volume hierarchy), the layout and balancing follow Box2D's b2DynamicTree
+// leaves store a slightly fattened box so small movements don't have to touch the tree at all
+
+static const int AABB_NULL_NODE = -1;
+
+struct AABBTreeNode {
+	BoundingBox box;
+	void* userData = nullptr;
+
+	int parent = AABB_NULL_NODE; // next free node while on the free list
+	int left = AABB_NULL_NODE;
+	int right = AABB_NULL_NODE;
+
+	int height = -1; // 0 for leaves, -1 while free
+
+	bool IsLeaf() const { return left == AABB_NULL_NODE; }
+};
+
+static BoundingBox BoxUnion(const BoundingBox& a, const BoundingBox& b) {
+	return {Vector3Min(a.min, b.min), Vector3Max(a.max, b.max)};
+}
+
+static float BoxSurfaceArea(const BoundingBox& b) {
+	Vector3 d = Vector3Subtract(b.max, b.min);
+	return 2.0f * (d.x*d.y + d.y*d.z + d.z*d.x);
+}
+
+static bool BoxContainsBox(const BoundingBox& outer, const BoundingBox& inner) {
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+		   outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+static bool BoxesOverlap(const BoundingBox& a, const BoundingBox& b) {
+	return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+		   a.min.y <= b.max.y && a.max.y >= b.min.y &&
+		   a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// slab test, true if the ray enters the box somewhere in [0, maxDistance]
+static bool RayIntersectsBox(Vector3 origin, Vector3 direction, const BoundingBox& box, float maxDistance) {
+	const float o[3] = {origin.x, origin.y, origin.z};
+	const float d[3] = {direction.x, direction.y, direction.z};
+	const float bmin[3] = {box.min.x, box.min.y, box.min.z};
+	const float bmax[3] = {box.max.x, box.max.y, box.max.z};
+
+	float tmin = 0.0f;
+	float tmax = maxDistance;
+
+	for (int i = 0; i < 3; i++) {
+		if (fabsf(d[i]) < 1e-8f) {
+			if (o[i] < bmin[i] || o[i] > bmax[i]) return false;
+			continue;
+		}
+
+		float inv = 1.0f / d[i];
+		float t1 = (bmin[i] - o[i]) * inv;
+		float t2 = (bmax[i] - o[i]) * inv;
+		if (t1 > t2) std::swap(t1, t2);
+
+		tmin = std::max(tmin, t1);
+		tmax = std::min(tmax, t2);
+		if (tmin > tmax) return false;
+	}
+
+	return true;
+}
+
+struct AABBTree {
+	std::vector<AABBTreeNode> nodes;
+	int root = AABB_NULL_NODE;
+	int freeList = AABB_NULL_NODE;
+
+	// how much leaf boxes are grown by in every direction
+	float margin = 0.5f;
+
+	int CreateProxy(const BoundingBox& box, void* userData) {
+		int proxy = AllocateNode();
+
+		nodes[proxy].box = Fatten(box);
+		nodes[proxy].userData = userData;
+		nodes[proxy].height = 0;
+
+		InsertLeaf(proxy);
+		return proxy;
+	}
+
+	void DestroyProxy(int proxy) {
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+	}
+
+	// returns true if the proxy had to be reinserted
+	bool MoveProxy(int proxy, const BoundingBox& box) {
+		if (BoxContainsBox(nodes[proxy].box, box)) {
+			// still fits, unless the leaf got far too large for what it holds (shrunk part)
+			BoundingBox loose = box;
+			Vector3 slack = {margin * 4.0f, margin * 4.0f, margin * 4.0f};
+			loose.min = Vector3Subtract(loose.min, slack);
+			loose.max = Vector3Add(loose.max, slack);
+
+			if (BoxContainsBox(loose, nodes[proxy].box))
+				return false;
+		}
+
+		RemoveLeaf(proxy);
+		nodes[proxy].box = Fatten(box);
+		InsertLeaf(proxy);
+
+		return true;
+	}
+
+	void* GetUserData(int proxy) const {
+		return nodes[proxy].userData;
+	}
+
+	// callback(void* userData) -> bool, return false to stop the query
+	template<typename F>
+	void Query(const BoundingBox& box, F callback) const {
+		std::vector<int> stack;
+		stack.push_back(root);
+
+		while (!stack.empty()) {
+			int index = stack.back();
+			stack.pop_back();
+
+			if (index == AABB_NULL_NODE) continue;
+
+			const AABBTreeNode& node = nodes[index];
+			if (!BoxesOverlap(node.box, box)) continue;
+
+			if (node.IsLeaf()) {
+				if (!callback(node.userData)) return;
+			} else {
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	// callback(void* userData, float maxDistance) -> float, return the distance of a closer hit
+	// to clip the ray, maxDistance to keep going, or 0 to stop
+	template<typename F>
+	void RayCast(Vector3 origin, Vector3 direction, float maxDistance, F callback) const {
+		std::vector<int> stack;
+		stack.push_back(root);
+
+		while (!stack.empty()) {
+			int index = stack.back();
+			stack.pop_back();
+
+			if (index == AABB_NULL_NODE) continue;
+
+			const AABBTreeNode& node = nodes[index];
+			if (!RayIntersectsBox(origin, direction, node.box, maxDistance)) continue;
+
+			if (node.IsLeaf()) {
+				float value = callback(node.userData, maxDistance);
+				if (value <= 0.0f) return;
+
+				maxDistance = std::min(maxDistance, value);
+			} else {
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	BoundingBox Fatten(const BoundingBox& box) const {
+		Vector3 grow = {margin, margin, margin};
+		return {Vector3Subtract(box.min, grow), Vector3Add(box.max, grow)};
+	}
+
+	int AllocateNode() {
+		if (freeList == AABB_NULL_NODE) {
+			nodes.emplace_back();
+			return (int)nodes.size() - 1;
+		}
+
+		int index = freeList;
+		freeList = nodes[index].parent;
+
+		nodes[index] = AABBTreeNode{};
+		return index;
+	}
+
+	void FreeNode(int index) {
+		nodes[index].parent = freeList;
+		nodes[index].userData = nullptr;
+		nodes[index].height = -1;
+		freeList = index;
+	}
+
+	void InsertLeaf(int leaf) {
+		if (root == AABB_NULL_NODE) {
+			root = leaf;
+			nodes[root].parent = AABB_NULL_NODE;
+			return;
+		}
+
+		// find the cheapest sibling by surface area
+		BoundingBox leafBox = nodes[leaf].box;
+		int index = root;
+
+		while (!nodes[index].IsLeaf()) {
+			int left = nodes[index].left;
+			int right = nodes[index].right;
+
+			float area = BoxSurfaceArea(nodes[index].box);
+			float combinedArea = BoxSurfaceArea(BoxUnion(nodes[index].box, leafBox));
+
+			// cost of pairing the leaf with this node, and of pushing it further down
+			float cost = 2.0f * combinedArea;
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](int child) {
+				float unionArea = BoxSurfaceArea(BoxUnion(leafBox, nodes[child].box));
+				if (nodes[child].IsLeaf())
+					return unionArea + inheritanceCost;
+
+				return (unionArea - BoxSurfaceArea(nodes[child].box)) + inheritanceCost;
+			};
+
+			float costLeft = descendCost(left);
+			float costRight = descendCost(right);
+
+			if (cost < costLeft && cost < costRight) break;
+
+			index = (costLeft < costRight) ? left : right;
+		}
+
+		int sibling = index;
+		int oldParent = nodes[sibling].parent;
+		int newParent = AllocateNode();
+
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].box = BoxUnion(leafBox, nodes[sibling].box);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].left = sibling;
+		nodes[newParent].right = leaf;
+
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if (oldParent != AABB_NULL_NODE) {
+			if (nodes[oldParent].left == sibling)
+				nodes[oldParent].left = newParent;
+			else
+				nodes[oldParent].right = newParent;
+		} else {
+			root = newParent;
+		}
+
+		Refit(nodes[leaf].parent);
+	}
+
+	void RemoveLeaf(int leaf) {
+		if (leaf == root) {
+			root = AABB_NULL_NODE;
+			return;
+		}
+
+		int parent = nodes[leaf].parent;
+		int grandParent = nodes[parent].parent;
+		int sibling = (nodes[parent].left == leaf) ? nodes[parent].right : nodes[parent].left;
+
+		if (grandParent != AABB_NULL_NODE) {
+			if (nodes[grandParent].left == parent)
+				nodes[grandParent].left = sibling;
+			else
+				nodes[grandParent].right = sibling;
+
+			nodes[sibling].parent = grandParent;
+			FreeNode(parent);
+
+			Refit(grandParent);
+		} else {
+			root = sibling;
+			nodes[sibling].parent = AABB_NULL_NODE;
+			FreeNode(parent);
+		}
+	}
+
+	// walks up from index, rebalancing and fixing boxes and heights
+	void Refit(int index) {
+		while (index != AABB_NULL_NODE) {
+			index = Balance(index);
+
+			int left = nodes[index].left;
+			int right = nodes[index].right;
+
+			nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+			nodes[index].box = BoxUnion(nodes[left].box, nodes[right].box);
+
+			index = nodes[index].parent;
+		}
+	}
+
+	// rotates a child up if the subtree at iA is imbalanced, returns the new subtree root
+	int Balance(int iA) {
+		if (nodes[iA].IsLeaf() || nodes[iA].height < 2)
+			return iA;
+
+		int iB = nodes[iA].left;
+		int iC = nodes[iA].right;
+
+		int balance = nodes[iC].height - nodes[iB].height;
+
+		// rotate C up
+		if (balance > 1) {
+			int iF = nodes[iC].left;
+			int iG = nodes[iC].right;
+
+			nodes[iC].left = iA;
+			nodes[iC].parent = nodes[iA].parent;
+			nodes[iA].parent = iC;
+
+			ReplaceChild(nodes[iC].parent, iA, iC);
+
+			if (nodes[iF].height > nodes[iG].height) {
+				nodes[iC].right = iF;
+				nodes[iA].right = iG;
+				nodes[iG].parent = iA;
+
+				nodes[iA].box = BoxUnion(nodes[iB].box, nodes[iG].box);
+				nodes[iC].box = BoxUnion(nodes[iA].box, nodes[iF].box);
+
+				nodes[iA].height = 1 + std::max(nodes[iB].height, nodes[iG].height);
+				nodes[iC].height = 1 + std::max(nodes[iA].height, nodes[iF].height);
+			} else {
+				nodes[iC].right = iG;
+				nodes[iA].right = iF;
+				nodes[iF].parent = iA;
+
+				nodes[iA].box = BoxUnion(nodes[iB].box, nodes[iF].box);
+				nodes[iC].box = BoxUnion(nodes[iA].box, nodes[iG].box);
+
+				nodes[iA].height = 1 + std::max(nodes[iB].height, nodes[iF].height);
+				nodes[iC].height = 1 + std::max(nodes[iA].height, nodes[iG].height);
+			}
+
+			return iC;
+		}
+
+		// rotate B up
+		if (balance < -1) {
+			int iD = nodes[iB].left;
+			int iE = nodes[iB].right;
+
+			nodes[iB].left = iA;
+			nodes[iB].parent = nodes[iA].parent;
+			nodes[iA].parent = iB;
+
+			ReplaceChild(nodes[iB].parent, iA, iB);
+
+			if (nodes[iD].height > nodes[iE].height) {
+				nodes[iB].right = iD;
+				nodes[iA].left = iE;
+				nodes[iE].parent = iA;
+
+				nodes[iA].box = BoxUnion(nodes[iC].box, nodes[iE].box);
+				nodes[iB].box = BoxUnion(nodes[iA].box, nodes[iD].box);
+
+				nodes[iA].height = 1 + std::max(nodes[iC].height, nodes[iE].height);
+				nodes[iB].height = 1 + std::max(nodes[iA].height, nodes[iD].height);
+			} else {
+				nodes[iB].right = iE;
+				nodes[iA].left = iD;
+				nodes[iD].parent = iA;
+
+				nodes[iA].box = BoxUnion(nodes[iC].box, nodes[iD].box);
+				nodes[iB].box = BoxUnion(nodes[iA].box, nodes[iE].box);
+
+				nodes[iA].height = 1 + std::max(nodes[iC].height, nodes[iD].height);
+				nodes[iB].height = 1 + std::max(nodes[iA].height, nodes[iE].height);
+			}
+
+			return iB;
+		}
+
+		return iA;
+	}
+
+	void ReplaceChild(int parent, int oldChild, int newChild) {
+		if (parent == AABB_NULL_NODE) {
+			root = newChild;
+			return;
+		}
+
+		if (nodes[parent].left == oldChild)
+			nodes[parent].left = newChild;
+		else
+			nodes[parent].right = newChild;
+	}
+};
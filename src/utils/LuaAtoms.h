@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// method and property names known to the engine, Luau tags every string it interns with its
+// index here so __namecall and the property tables can use the atom instead of comparing strings
+#define LUA_ATOMS(X) \
+	X(Clone) X(GetChildren) X(GetDescendants) X(Destroy) \
+	X(GetService) X(FindService) \
+	X(Play) X(Stop) \
+	X(Raycast) X(GetPartBoundsInBox) \
+	X(AddItem) X(addItem) \
+	X(GetSunDirection) \
+	X(DrawText) X(DrawLine2D) X(DrawArrow2D) X(DrawLine3D) X(DrawArrow3D) X(DrawRectangle) X(DrawRectangleOutline) \
+	X(Abs) X(Ceil) X(Floor) X(Sign) X(Cross) X(Angle) X(Dot) X(FuzzyEq) X(Lerp) X(Max) X(Min) \
+	X(NextNumber) X(NextInteger) X(Shuffle) X(NextUnitVector) \
+	X(Connect) X(Fire) \
+	X(Name) X(Parent) X(ClassName) \
+	X(Position) X(Rotation) X(Size) X(Velocity) X(Color) X(Transparency) X(Shape) X(Anchored) X(Material) \
+	X(AnchorPoint) X(BackgroundColor3) X(BackgroundTransparency) X(Visible) \
+	X(Text) X(TextColor) X(TextTransparency) X(TextSize) \
+	X(CornerRadius) X(Source) \
+	X(Enabled) X(IgnoreGuiInset) X(AbsolutePosition) X(AbsoluteSize)
+
+enum LuaAtom : int16_t {
+#define X(name) ATOM_##name,
+	LUA_ATOMS(X)
+#undef X
+	ATOM_COUNT
+};
+
+static const char* const LuaAtomNames[] = {
+#define X(name) #name,
+	LUA_ATOMS(X)
+#undef X
+};
+
+// installed as lua_callbacks(L)->useratom, runs once per interned string
+static int16_t LuaUserAtom(const char* s, size_t l) {
+	for (int16_t i = 0; i < ATOM_COUNT; i++) {
+		if (std::strlen(LuaAtomNames[i]) == l && std::memcmp(LuaAtomNames[i], s, l) == 0)
+			return i;
+	}
+
+	return -1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "lua.h"
+#include "lualib.h"
+
+// userdata tags for every engine type, the VM keeps one metatable and destructor per tag
+// so creating and checking a value never touches the registry, tag 0 is plain userdata
+enum LuaUserdataTag {
+	LUA_TAG_INSTANCE = 1,
+	LUA_TAG_VECTOR2,
+	LUA_TAG_UDIM,
+	LUA_TAG_UDIM2,
+	LUA_TAG_COLOR3,
+	LUA_TAG_CFRAME,
+	LUA_TAG_AXES,
+	LUA_TAG_RANDOM,
+	LUA_TAG_SIGNAL,
+	LUA_TAG_CONNECTION,
+};
+
+static void* CheckUserdataTagged(lua_State* L, int idx, int tag, const char* typeName) {
+	void* data = lua_touserdatatagged(L, idx, tag);
+	if (!data)
+		luaL_typeerror(L, idx, typeName);
+
+	return data;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 32 bit slot index plus the generation the slot had when the handle was made,
+// generation 0 is never handed out so a default handle is always null
+struct SlotHandle {
+	uint32_t index = 0;
+	uint32_t generation = 0;
+};
+
+// pointers addressed by handle, freeing a slot bumps its generation so every handle
+// still pointing at it resolves to nullptr without having to be tracked down
+template<typename T>
+struct SlotMap {
+	struct Slot {
+		T* value = nullptr;
+		uint32_t generation = 1;
+	};
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+
+	SlotHandle Insert(T* value) {
+		uint32_t index;
+
+		if (!freeSlots.empty()) {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		} else {
+			index = (uint32_t)slots.size();
+			slots.push_back({});
+		}
+
+		slots[index].value = value;
+		return {index, slots[index].generation};
+	}
+
+	void Erase(SlotHandle handle) {
+		if (!Get(handle)) return;
+
+		Slot& slot = slots[handle.index];
+		slot.value = nullptr;
+
+		// skip 0 when it wraps around
+		if (++slot.generation == 0)
+			slot.generation = 1;
+
+		freeSlots.push_back(handle.index);
+	}
+
+	T* Get(SlotHandle handle) const {
+		if (handle.index >= slots.size()) return nullptr;
+
+		const Slot& slot = slots[handle.index];
+		return slot.generation == handle.generation ? slot.value : nullptr;
+	}
+
+	// walks the slot array in order, skipping free slots
+	template<typename F>
+	void ForEach(F&& fn) const {
+		for (const Slot& slot : slots) {
+			if (slot.value)
+				fn(slot.value);
+		}
+	}
+};
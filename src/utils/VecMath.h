@@ -42,3 +42,80 @@ static Vector3 SunDirFromClock(float clockHours, float maxElevationDeg = 60.0f,
 
     return Vector3Normalize(dir);
 }
+
+// view frustum as 6 planes (xyz = normal pointing inwards, w = distance)
+struct Frustum {
+    Vector4 planes[6];
+};
+
+static Vector4 NormalizePlane(Vector4 plane) {
+    float length = sqrtf(plane.x*plane.x + plane.y*plane.y + plane.z*plane.z);
+    if (length <= 0.0f) return plane;
+
+    return {plane.x / length, plane.y / length, plane.z / length, plane.w / length};
+}
+
+// extracts the planes from a view * projection matrix (Gribb & Hartmann)
+static Frustum FrustumFromMatrix(Matrix m) {
+    Frustum frustum;
+
+    frustum.planes[0] = NormalizePlane({m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8, m.m15 + m.m12}); // left
+    frustum.planes[1] = NormalizePlane({m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8, m.m15 - m.m12}); // right
+    frustum.planes[2] = NormalizePlane({m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9, m.m15 + m.m13}); // bottom
+    frustum.planes[3] = NormalizePlane({m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9, m.m15 - m.m13}); // top
+    frustum.planes[4] = NormalizePlane({m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14}); // near
+    frustum.planes[5] = NormalizePlane({m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14}); // far
+
+    return frustum;
+}
+
+// conservative test, boxes near the corners of the frustum may pass while being outside
+static bool FrustumContainsBox(const Frustum& frustum, const BoundingBox& box) {
+    for (const Vector4& plane : frustum.planes) {
+        // corner of the box furthest along the plane normal
+        Vector3 p = {
+            plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z
+        };
+
+        if (plane.x*p.x + plane.y*p.y + plane.z*p.z + plane.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+// separating axis test between an oriented box (unit axes, half extents) and an AABB
+static bool OrientedBoxOverlapsBox(Vector3 center, const Vector3 axes[3], Vector3 half, const BoundingBox& box) {
+    const Vector3 worldAxes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    Vector3 boxHalf = Vector3Scale(Vector3Subtract(box.max, box.min), 0.5f);
+    Vector3 offset = Vector3Subtract(center, Vector3Scale(Vector3Add(box.min, box.max), 0.5f));
+
+    auto separated = [&](Vector3 axis) {
+        // parallel edges give a zero cross product, already covered by the face axes
+        if (Vector3DotProduct(axis, axis) < 1e-10f) return false;
+
+        float ra = fabsf(Vector3DotProduct(axes[0], axis)) * half.x +
+                   fabsf(Vector3DotProduct(axes[1], axis)) * half.y +
+                   fabsf(Vector3DotProduct(axes[2], axis)) * half.z;
+        float rb = fabsf(axis.x) * boxHalf.x + fabsf(axis.y) * boxHalf.y + fabsf(axis.z) * boxHalf.z;
+
+        return fabsf(Vector3DotProduct(offset, axis)) > ra + rb;
+    };
+
+    for (int i = 0; i < 3; i++) {
+        if (separated(worldAxes[i]) || separated(axes[i]))
+            return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (separated(Vector3CrossProduct(axes[i], worldAxes[j])))
+                return false;
+        }
+    }
+
+    return true;
+}